@@ -9,5 +9,11 @@
 
 Q_DECLARE_METATYPE(KIO::UDSEntryList)
 
+/**
+ * Set on entries the helper gave up stat'ing, e.g. mount points of network shares that don't answer. Such entries
+ * only carry their name and type.
+ */
+constexpr uint UDS_ADMIN_INCOMPLETE = 0x7ffe | KIO::UDSEntry::UDS_NUMBER;
+
 QDBusArgument &operator<<(QDBusArgument &argument, const KIO::UDSEntry &entry);
 const QDBusArgument &operator>>(const QDBusArgument &argument, KIO::UDSEntry &entry);
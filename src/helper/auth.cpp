@@ -11,11 +11,20 @@
 
 bool isAuthorized(QDBusContext *context)
 {
+    return isAuthorized(context->message().service());
+}
+
+bool isAuthorized(const QString &service)
+{
+    if (service.isEmpty()) {
+        return false; // Not in a call.
+    }
+
     const auto action = QStringLiteral("org.kde.kio.admin.commands");
 
     auto authority = PolkitQt1::Authority::instance();
     PolkitQt1::Authority::Result result =
-        authority->checkAuthorizationSync(action, PolkitQt1::SystemBusNameSubject(context->message().service()), PolkitQt1::Authority::AllowUserInteraction);
+        authority->checkAuthorizationSync(action, PolkitQt1::SystemBusNameSubject(service), PolkitQt1::Authority::AllowUserInteraction);
 
     if (authority->hasError()) {
         authority->clearError();
@@ -4,8 +4,11 @@
 #pragma once
 
 class QDBusContext;
+class QString;
 
 bool isAuthorized(QDBusContext *context);
+/** @returns whether the caller behind the unique bus name \a service may run commands. */
+bool isAuthorized(const QString &service);
 
 #undef Q_EMIT
 #define Q_EMIT #error "don't use emit directly use BusObject sendSignal"
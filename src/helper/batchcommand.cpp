@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "batchcommand.h"
+
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <QFile>
+
+#include <KIO/Global>
+
+#include "batchjob.h"
+#include "fsutil.h"
+#include "localentry.h"
+#include "treedeletejob.h"
+
+namespace
+{
+// Read-only for the pool once the job started, except for the entries slot owned by each item.
+struct BatchState {
+    std::vector<QByteArray> paths;
+    std::vector<QByteArray> destinations;
+    std::vector<KIO::UDSEntry> entries;
+};
+} // namespace
+
+BatchCommand::BatchCommand(Operation operation,
+                           const QList<QUrl> &urls,
+                           const QList<QUrl> &destinations,
+                           int parameter,
+                           const QString &remoteService,
+                           const QDBusObjectPath &objectPath,
+                           QObject *parent)
+    : BusObject(remoteService, objectPath, parent)
+    , m_operation(operation)
+    , m_urls(urls)
+    , m_destinations(destinations)
+    , m_parameter(parameter)
+{
+}
+
+void BatchCommand::start()
+{
+    if (!isAuthorized()) {
+        sendErrorReply(QDBusError::AccessDenied);
+        return;
+    }
+
+    if (m_operation == Operation::Rename && m_destinations.size() != m_urls.size()) {
+        sendSignal(&BatchCommand::result, int(KIO::ERR_MALFORMED_URL), QString());
+        deleteLater();
+        return;
+    }
+
+    if (m_operation == Operation::Delete) {
+        startDelete();
+        return;
+    }
+
+    // Shared with the operation. Killing the job deletes us while tasks may still be winding down.
+    auto state = std::make_shared<BatchState>();
+    for (const auto &url : m_urls) {
+        state->paths.push_back(url.isLocalFile() ? QFile::encodeName(url.toLocalFile()) : QByteArray());
+    }
+    for (const auto &url : m_destinations) {
+        state->destinations.push_back(url.isLocalFile() ? QFile::encodeName(url.toLocalFile()) : QByteArray());
+    }
+
+    BatchJob::Operation operation;
+    switch (m_operation) {
+    case Operation::Stat: {
+        state->entries.resize(state->paths.size());
+        const KIO::StatDetails details(m_parameter);
+        operation = [state, details](qsizetype index, QString &errorText) {
+            const auto &path = state->paths.at(index);
+            errorText = QFile::decodeName(path);
+            if (path.isEmpty() || !canCreateLocalUDSEntry(details)) {
+                return int(KIO::ERR_UNSUPPORTED_ACTION);
+            }
+            const auto slash = path.lastIndexOf('/');
+            if (!createLocalUDSEntry(AT_FDCWD, path, QFile::decodeName(path.mid(slash + 1)), path, details, state->entries.at(index))) {
+                return errnoToKIOError(errno, KIO::ERR_DOES_NOT_EXIST);
+            }
+            return 0;
+        };
+        break;
+    }
+    case Operation::Chmod: {
+        const auto permissions = m_parameter & 07777;
+        operation = [state, permissions](qsizetype index, QString &errorText) {
+            const auto &path = state->paths.at(index);
+            errorText = QFile::decodeName(path);
+            if (path.isEmpty()) {
+                return int(KIO::ERR_UNSUPPORTED_ACTION);
+            }
+            // Follows symlinks, as the file worker's chmod does.
+            if (fchmodat(AT_FDCWD, path.constData(), permissions, 0) != 0) {
+                return errnoToKIOError(errno, KIO::ERR_CANNOT_CHMOD);
+            }
+            return 0;
+        };
+        break;
+    }
+    case Operation::Rename: {
+        const auto flags = KIO::JobFlags(m_parameter).testFlag(KIO::Overwrite) ? 0U : RENAME_NOREPLACE;
+        operation = [state, flags](qsizetype index, QString &errorText) {
+            const auto &src = state->paths.at(index);
+            const auto &dst = state->destinations.at(index);
+            errorText = QFile::decodeName(src);
+            if (src.isEmpty() || dst.isEmpty()) {
+                return int(KIO::ERR_UNSUPPORTED_ACTION);
+            }
+            const int error = renamePath(src, dst, flags);
+            if (error == KIO::ERR_FILE_ALREADY_EXIST || error == KIO::ERR_DIR_ALREADY_EXIST) {
+                errorText = QFile::decodeName(dst);
+            }
+            return error;
+        };
+        break;
+    }
+    case Operation::Delete:
+        Q_UNREACHABLE();
+    }
+
+    auto job = new BatchJob(qsizetype(state->paths.size()), std::move(operation));
+    if (m_operation == Operation::Stat) {
+        job->setPriority(WorkStealingPool::Priority::Interactive);
+    }
+    // A rename may free the name a later one moves to, or move what a later one renames (a -> b, b -> c).
+    job->setSequential(m_operation == Operation::Rename);
+    setParent(job);
+    connect(job, &KJob::processedAmountChanged, this, [this](KJob *, KJob::Unit unit, qulonglong amount) {
+        if (unit == KJob::Files) {
+            sendSignal(&BatchCommand::processedItems, amount);
+        }
+    });
+    connect(job, &BatchJob::failures, this, [this](const QStringList &paths, const QList<int> &errors) {
+        sendSignal(&BatchCommand::failures, paths, errors);
+    });
+    if (m_operation == Operation::Stat) {
+        connect(job, &BatchJob::succeeded, this, [this, state](const QList<qsizetype> &indexes) {
+            QList<int> sentIndexes;
+            KIO::UDSEntryList entries;
+            sentIndexes.reserve(indexes.size());
+            entries.reserve(indexes.size());
+            for (const auto index : indexes) {
+                sentIndexes.append(int(index));
+                entries.append(std::exchange(state->entries.at(index), {}));
+            }
+            sendSignal(&BatchCommand::statEntries, sentIndexes, entries);
+        });
+    }
+    connect(job, &KJob::result, this, [this, job](KJob *) {
+        sendSignal(&BatchCommand::result, job->error(), job->errorString());
+    });
+    job->start();
+}
+
+void BatchCommand::startDelete()
+{
+    QList<QByteArray> paths;
+    for (const auto &url : m_urls) {
+        if (!url.isLocalFile()) {
+            sendSignal(&BatchCommand::result, int(KIO::ERR_UNSUPPORTED_ACTION), url.toString());
+            deleteLater();
+            return;
+        }
+        paths.append(QFile::encodeName(url.toLocalFile()));
+    }
+
+    auto job = new TreeDeleteJob(paths);
+    setParent(job);
+    connect(job, &KJob::processedAmountChanged, this, [this](KJob *, KJob::Unit unit, qulonglong amount) {
+        if (unit == KJob::Files) {
+            sendSignal(&BatchCommand::processedItems, amount);
+        }
+    });
+    connect(job, &KJob::result, this, [this, job](KJob *) {
+        sendSignal(&BatchCommand::result, job->error(), job->errorString());
+    });
+    job->start();
+}
+
+void BatchCommand::kill()
+{
+    doKill();
+}
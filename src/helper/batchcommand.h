@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <QList>
+#include <QStringList>
+#include <QUrl>
+
+#include <KIO/UDSEntry>
+
+#include "busobject.h"
+
+/**
+ * One command for a whole selection of URLs, instead of one command object and D-Bus path per URL.
+ *
+ * Items are processed in a single pass on the WorkStealingPool. Results stream back in batches: statEntries() refers to
+ * items by their index in the request, failures() carries the local path and KIO::Error of every failed item.
+ */
+class BatchCommand : public BusObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kio.admin.BatchCommand")
+public:
+    enum class Operation {
+        Stat, ///< parameter are the KIO::StatDetails
+        Delete,
+        Chmod, ///< parameter are the permissions
+        Rename, ///< parameter are the KIO::JobFlags, destinations the new URLs
+    };
+
+    explicit BatchCommand(Operation operation,
+                          const QList<QUrl> &urls,
+                          const QList<QUrl> &destinations,
+                          int parameter,
+                          const QString &remoteService,
+                          const QDBusObjectPath &objectPath,
+                          QObject *parent = nullptr);
+
+public Q_SLOTS:
+    void start();
+    void kill();
+
+Q_SIGNALS:
+    void statEntries(const QList<int> &indexes, const KIO::UDSEntryList &entries);
+    void processedItems(qulonglong items);
+    void failures(const QStringList &paths, const QList<int> &errors);
+    void result(int error, const QString &errorString);
+
+private:
+    void startDelete();
+
+    const Operation m_operation;
+    const QList<QUrl> m_urls;
+    const QList<QUrl> m_destinations;
+    const int m_parameter;
+};
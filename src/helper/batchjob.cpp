@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "batchjob.h"
+
+#include <algorithm>
+#include <atomic>
+#include <tuple>
+#include <utility>
+
+#include <QFile>
+
+namespace
+{
+constexpr qsizetype itemsPerTask = 32;
+} // namespace
+
+class BatchRunner : public PoolOperation
+{
+public:
+    BatchRunner(qsizetype count, BatchJob::Operation operation)
+        : m_count(count)
+        , m_operation(std::move(operation))
+    {
+    }
+
+    std::atomic<qulonglong> processed = 0;
+    bool sequential = false;
+
+    std::tuple<QList<qsizetype>, QStringList, QList<int>> takeResults()
+    {
+        std::lock_guard lock(m_mutex);
+        return {std::exchange(m_succeeded, {}), std::exchange(m_failedTexts, {}), std::exchange(m_failedErrors, {})};
+    }
+
+protected:
+    void run() override
+    {
+        if (sequential) {
+            schedule([self = sharedSelf<BatchRunner>()] {
+                self->process(0, self->m_count);
+            });
+            return;
+        }
+        for (qsizetype begin = 0; begin < m_count; begin += itemsPerTask) {
+            const auto end = std::min(begin + itemsPerTask, m_count);
+            schedule([self = sharedSelf<BatchRunner>(), begin, end] {
+                self->process(begin, end);
+            });
+        }
+    }
+
+private:
+    void process(qsizetype begin, qsizetype end)
+    {
+        for (auto index = begin; index < end && !isCanceled(); ++index) {
+            QString errorText;
+            const int error = m_operation(index, errorText);
+            ++processed;
+
+            if (error != 0) {
+                reportError(error, QFile::encodeName(errorText));
+            }
+            std::lock_guard lock(m_mutex);
+            if (error == 0) {
+                m_succeeded.append(index);
+            } else {
+                m_failedTexts.append(errorText);
+                m_failedErrors.append(error);
+            }
+        }
+    }
+
+    const qsizetype m_count;
+    const BatchJob::Operation m_operation;
+    QList<qsizetype> m_succeeded;
+    QStringList m_failedTexts;
+    QList<int> m_failedErrors;
+};
+
+BatchJob::BatchJob(qsizetype count, Operation operation, QObject *parent)
+    : BatchJob(std::make_shared<BatchRunner>(count, std::move(operation)), parent)
+{
+}
+
+BatchJob::BatchJob(const std::shared_ptr<BatchRunner> &runner, QObject *parent)
+    : PoolJob(runner, parent)
+    , m_runner(runner)
+{
+}
+
+BatchJob::~BatchJob() = default;
+
+void BatchJob::setSequential(bool sequential)
+{
+    m_runner->sequential = sequential;
+}
+
+void BatchJob::updateProgress()
+{
+    setProcessedAmount(KJob::Files, m_runner->processed);
+    const auto [indexes, errorTexts, errors] = m_runner->takeResults();
+    if (!indexes.isEmpty()) {
+        Q_EMIT succeeded(indexes);
+    }
+    if (!errorTexts.isEmpty()) {
+        Q_EMIT failures(errorTexts, errors);
+    }
+}
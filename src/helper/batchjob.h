@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include <QList>
+#include <QStringList>
+
+#include "pooljob.h"
+
+class BatchRunner;
+
+/**
+ * Runs one operation for each of a list of items, in chunks on the WorkStealingPool.
+ *
+ * Failing items don't abort the batch. Finished and failed items are reported in batches through succeeded() and
+ * failures(), the number of processed items as KJob::Files. The result carries the first failure.
+ */
+class BatchJob : public PoolJob
+{
+    Q_OBJECT
+public:
+    /** Processes item \a index. @returns 0 or a KIO::Error, in which case \a errorText names the culprit. */
+    using Operation = std::function<int(qsizetype index, QString &errorText)>;
+
+    BatchJob(qsizetype count, Operation operation, QObject *parent = nullptr);
+    ~BatchJob() override;
+
+    /** Processes the items one after the other in their order, for operations that may depend on each other. Call before start(). */
+    void setSequential(bool sequential);
+
+Q_SIGNALS:
+    void succeeded(const QList<qsizetype> &indexes);
+    void failures(const QStringList &errorTexts, const QList<int> &errors);
+
+protected:
+    void updateProgress() override;
+
+private:
+    BatchJob(const std::shared_ptr<BatchRunner> &runner, QObject *parent);
+
+    const std::shared_ptr<BatchRunner> m_runner;
+};
@@ -3,26 +3,123 @@
 
 #include "busobject.h"
 
+#include <algorithm>
+#include <utility>
+
+#include <QDateTime>
+#include <QPointer>
+
 #include <KJob>
 
 #include "auth.h"
+#include "commandtable.h"
+#include "pooljob.h"
 
 BusObject::BusObject(const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
     : QObject(parent)
     , m_remoteService(remoteService)
     , m_objectPath(objectPath)
 {
+    CommandTable::instance().attach(m_objectPath, this);
+}
+
+BusObject::~BusObject()
+{
+    releaseBuffer(m_bufferedBytes);
+    CommandTable::instance().detach(m_objectPath);
+}
+
+bool BusObject::dispatch(const QDBusMessage &message, const QDBusConnection &connection, const std::function<void()> &call)
+{
+    // Calls may nest through event loops run by the slots, each restores its predecessor.
+    Call current{message, connection};
+    const auto previous = std::exchange(m_call, &current);
+    QPointer self(this);
+    call();
+    if (self) {
+        m_call = previous;
+    }
+    return current.replied;
+}
+
+void BusObject::setDeadline(qint64 msecsSinceEpoch)
+{
+    // Only ever drops the command, which is the client's to decide. No need for a round trip to polkit.
+    if (message().service() != m_remoteService) {
+        sendErrorReply(QDBusError::AccessDenied);
+        return;
+    }
+
+    const auto remaining = msecsSinceEpoch - QDateTime::currentMSecsSinceEpoch();
+    if (remaining <= 0) {
+        qCDebug(KIOADMIN_LOG) << m_objectPath.path() << "expired before it started";
+        m_expired = true;
+        reap();
+        return;
+    }
+    if (!m_deadlineTimer) {
+        m_deadlineTimer = new QTimer(this);
+        m_deadlineTimer->setSingleShot(true);
+        connect(m_deadlineTimer, &QTimer::timeout, this, [this] {
+            qCDebug(KIOADMIN_LOG) << m_objectPath.path() << "expired";
+            m_expired = true;
+            reap();
+        });
+    }
+    m_deadlineTimer->start(std::chrono::milliseconds(remaining));
+}
+
+bool BusObject::isExpired() const
+{
+    return m_expired;
+}
+
+bool BusObject::isIdle() const
+{
+    return !m_job;
+}
+
+void BusObject::reap()
+{
+    if (m_job) {
+        m_job->kill(); // Takes us along.
+        return;
+    }
+    deleteLater();
+}
+
+QDBusMessage BusObject::message() const
+{
+    return m_call ? m_call->message : QDBusMessage();
+}
+
+QDBusConnection BusObject::connection() const
+{
+    return m_call ? m_call->connection : QDBusConnection::systemBus();
+}
+
+void BusObject::sendErrorReply(QDBusError::ErrorType type, const QString &errorMessage)
+{
+    Q_ASSERT(m_call);
+    if (!m_call || m_call->replied) {
+        return;
+    }
+    m_call->replied = true;
+    m_call->connection.send(m_call->message.createErrorReply(type, errorMessage));
 }
 
 bool BusObject::isAuthorized()
 {
-    return ::isAuthorized(this);
+    return ::isAuthorized(message().service());
 }
 
 void BusObject::setParent(KJob *parent)
 {
     QObject::setParent(parent);
     m_job = parent;
+    if (auto poolJob = qobject_cast<PoolJob *>(parent)) {
+        poolJob->setClient(m_remoteService);
+    }
 }
 
 void BusObject::doKill()
@@ -36,3 +133,22 @@ void BusObject::doKill()
         m_job->kill();
     }
 }
+
+bool BusObject::acquireBuffer(qint64 bytes)
+{
+    if (!CommandTable::instance().acquireBuffer(m_remoteService, bytes)) {
+        return false;
+    }
+    m_bufferedBytes += bytes;
+    return true;
+}
+
+void BusObject::releaseBuffer(qint64 bytes)
+{
+    bytes = std::min(bytes, m_bufferedBytes);
+    if (bytes <= 0) {
+        return;
+    }
+    m_bufferedBytes -= bytes;
+    CommandTable::instance().releaseBuffer(m_remoteService, bytes);
+}
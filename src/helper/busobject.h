@@ -3,23 +3,53 @@
 
 #pragma once
 
+#include <functional>
+
 #include <QDBusConnection>
-#include <QDBusContext>
+#include <QDBusError>
 #include <QDBusMessage>
 #include <QDBusObjectPath>
 #include <QMetaMethod>
+#include <QTimer>
 
 #include "../kioadmin_debug.h"
 
 class KJob;
 
-class BusObject : public QObject, protected QDBusContext
+/**
+ * Base of all command objects. Calls reach commands through the CommandTable rather than a registration of their own,
+ * message(), connection() and sendErrorReply() stand in for QDBusContext while a call is dispatched.
+ */
+class BusObject : public QObject
 {
     Q_OBJECT
 public:
+    ~BusObject() override;
+
     void setParent(QObject *parent) = delete;
 
+    QDBusObjectPath objectPath() const
+    {
+        return m_objectPath;
+    }
+
+    /** Runs \a call with \a message as the current call. @returns whether a reply was sent meanwhile. */
+    bool dispatch(const QDBusMessage &message, const QDBusConnection &connection, const std::function<void()> &call);
+
+    /**
+     * Has the command reaped at \a msecsSinceEpoch, started or not, because its client doesn't want the result anymore
+     * by then. Reached through the org.kde.kio.admin.Command interface every command shares.
+     */
+    void setDeadline(qint64 msecsSinceEpoch);
+    [[nodiscard]] bool isExpired() const;
+
+    /** Whether the command merely waits for its client to call it, rather than working or watching on its own. */
+    [[nodiscard]] virtual bool isIdle() const;
+    /** Ends the command because its client is gone or forgot about it. */
+    virtual void reap();
+
 protected:
+    /** Claims \a objectPath, which must come from CommandTable::reserve(). */
     BusObject(const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent = nullptr);
 
     template<typename PointerToMemberFunction, typename... Args>
@@ -35,13 +65,31 @@ protected:
         QDBusConnection::systemBus().send(message);
     }
 
+    [[nodiscard]] QDBusMessage message() const;
+    [[nodiscard]] QDBusConnection connection() const;
+    void sendErrorReply(QDBusError::ErrorType type, const QString &errorMessage = QString());
+
     bool isAuthorized();
     void setParent(KJob *parent);
     void doKill();
 
+    /** Accounts for \a bytes held on behalf of the client. @returns false when the client is over its limit. */
+    bool acquireBuffer(qint64 bytes);
+    void releaseBuffer(qint64 bytes);
+
 private:
+    struct Call {
+        QDBusMessage message;
+        QDBusConnection connection;
+        bool replied = false;
+    };
+
     const QString m_remoteService;
     const QDBusObjectPath m_objectPath;
 
     KJob *m_job = nullptr;
+    Call *m_call = nullptr;
+    qint64 m_bufferedBytes = 0;
+    QTimer *m_deadlineTimer = nullptr;
+    bool m_expired = false;
 };
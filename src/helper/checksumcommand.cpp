@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "checksumcommand.h"
+
+#include <QFile>
+
+#include <KIO/Global>
+
+#include "checksumjob.h"
+
+ChecksumCommand::ChecksumCommand(const QUrl &url, const QString &algorithm, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
+    : BusObject(remoteService, objectPath, parent)
+    , m_url(url)
+    , m_algorithm(algorithm)
+{
+}
+
+void ChecksumCommand::start()
+{
+    if (!isAuthorized()) {
+        sendErrorReply(QDBusError::AccessDenied);
+        return;
+    }
+
+    const auto algorithm = checksumAlgorithm(m_algorithm);
+    if (!algorithm) {
+        sendSignal(&ChecksumCommand::result, int(KIO::ERR_UNSUPPORTED_ACTION), m_algorithm);
+        deleteLater();
+        return;
+    }
+    if (!m_url.isLocalFile()) {
+        sendSignal(&ChecksumCommand::result, int(KIO::ERR_UNSUPPORTED_ACTION), m_url.toString());
+        deleteLater();
+        return;
+    }
+
+    auto job = new ChecksumJob(QFile::encodeName(m_url.toLocalFile()), algorithm.value());
+    setParent(job);
+    connect(job, &KJob::processedAmountChanged, this, [this](KJob *, KJob::Unit unit, qulonglong amount) {
+        if (unit == KJob::Bytes) {
+            sendSignal(&ChecksumCommand::processedSize, amount);
+        }
+    });
+    connect(job, &KJob::result, this, [this, job](KJob *) {
+        if (job->error() == KJob::NoError) {
+            sendSignal(&ChecksumCommand::checksum, QString::fromLatin1(job->digest().toHex()));
+        }
+        sendSignal(&ChecksumCommand::result, job->error(), job->errorString());
+    });
+    job->start();
+}
+
+void ChecksumCommand::kill()
+{
+    doKill();
+}
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <QUrl>
+
+#include "busobject.h"
+
+/** Computes a file's digest in place instead of shipping its content, see ChecksumJob. */
+class ChecksumCommand : public BusObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kio.admin.ChecksumCommand")
+public:
+    explicit ChecksumCommand(const QUrl &url,
+                             const QString &algorithm,
+                             const QString &remoteService,
+                             const QDBusObjectPath &objectPath,
+                             QObject *parent = nullptr);
+
+public Q_SLOTS:
+    void start();
+    void kill();
+
+Q_SIGNALS:
+    void processedSize(qulonglong bytes);
+    /** Hex encoded. Sent before result() when the file could be hashed. */
+    void checksum(const QString &digest);
+    void result(int error, const QString &errorString);
+
+private:
+    const QUrl m_url;
+    const QString m_algorithm;
+};
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "checksumjob.h"
+
+#include <atomic>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <KIO/Global>
+
+#include "fsutil.h"
+
+namespace
+{
+constexpr size_t blockSize = 1024 * 1024;
+} // namespace
+
+std::optional<QCryptographicHash::Algorithm> checksumAlgorithm(const QString &name)
+{
+    static const std::pair<QLatin1String, QCryptographicHash::Algorithm> algorithms[] = {
+        {QLatin1String("md5"), QCryptographicHash::Md5},
+        {QLatin1String("sha1"), QCryptographicHash::Sha1},
+        {QLatin1String("sha224"), QCryptographicHash::Sha224},
+        {QLatin1String("sha256"), QCryptographicHash::Sha256},
+        {QLatin1String("sha384"), QCryptographicHash::Sha384},
+        {QLatin1String("sha512"), QCryptographicHash::Sha512},
+        {QLatin1String("sha3-224"), QCryptographicHash::Sha3_224},
+        {QLatin1String("sha3-256"), QCryptographicHash::Sha3_256},
+        {QLatin1String("sha3-384"), QCryptographicHash::Sha3_384},
+        {QLatin1String("sha3-512"), QCryptographicHash::Sha3_512},
+        {QLatin1String("blake2b-256"), QCryptographicHash::Blake2b_256},
+        {QLatin1String("blake2b-384"), QCryptographicHash::Blake2b_384},
+        {QLatin1String("blake2b-512"), QCryptographicHash::Blake2b_512},
+        {QLatin1String("blake2s-224"), QCryptographicHash::Blake2s_224},
+        {QLatin1String("blake2s-256"), QCryptographicHash::Blake2s_256},
+    };
+    for (const auto &[algorithmName, algorithm] : algorithms) {
+        if (name.compare(algorithmName, Qt::CaseInsensitive) == 0) {
+            return algorithm;
+        }
+    }
+    return std::nullopt;
+}
+
+class FileHasher : public PoolOperation
+{
+public:
+    FileHasher(const QByteArray &path, QCryptographicHash::Algorithm algorithm)
+        : m_path(path)
+        , m_algorithm(algorithm)
+    {
+    }
+
+    std::atomic<qulonglong> processed = 0;
+    // Only read after the operation finished.
+    QByteArray digest;
+
+protected:
+    void run() override
+    {
+        // Non-blocking so a FIFO can't hold on to a pool thread before we get to check what we opened.
+        UniqueFd fd(open(m_path.constData(), O_RDONLY | O_NONBLOCK | O_NOFOLLOW | O_NOCTTY | O_CLOEXEC));
+        if (!fd.isValid()) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_OPEN_FOR_READING), m_path);
+            return;
+        }
+        struct stat stat {
+        };
+        if (fstat(fd.get(), &stat) != 0) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_READ), m_path);
+            return;
+        }
+        if (S_ISDIR(stat.st_mode)) {
+            fail(KIO::ERR_IS_DIRECTORY, m_path);
+            return;
+        }
+        // Devices like /dev/zero never end.
+        if (!S_ISREG(stat.st_mode)) {
+            fail(KIO::ERR_CANNOT_OPEN_FOR_READING, m_path);
+            return;
+        }
+        fcntl(fd.get(), F_SETFL, fcntl(fd.get(), F_GETFL) & ~O_NONBLOCK);
+        posix_fadvise(fd.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        QCryptographicHash hash(m_algorithm);
+        std::vector<char> buffer(blockSize);
+        while (!isCanceled()) {
+            const auto length = read(fd.get(), buffer.data(), buffer.size());
+            if (length < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                fail(errnoToKIOError(errno, KIO::ERR_CANNOT_READ), m_path);
+                return;
+            }
+            if (length == 0) {
+                digest = hash.result();
+                return;
+            }
+            hash.addData(QByteArrayView(buffer.data(), length));
+            processed += length;
+        }
+    }
+
+private:
+    const QByteArray m_path;
+    const QCryptographicHash::Algorithm m_algorithm;
+};
+
+ChecksumJob::ChecksumJob(const QByteArray &path, QCryptographicHash::Algorithm algorithm, QObject *parent)
+    : ChecksumJob(std::make_shared<FileHasher>(path, algorithm), parent)
+{
+}
+
+ChecksumJob::ChecksumJob(const std::shared_ptr<FileHasher> &hasher, QObject *parent)
+    : PoolJob(hasher, parent)
+    , m_hasher(hasher)
+{
+}
+
+ChecksumJob::~ChecksumJob() = default;
+
+QByteArray ChecksumJob::digest() const
+{
+    return m_hasher->digest;
+}
+
+void ChecksumJob::updateProgress()
+{
+    setProcessedAmount(KJob::Bytes, m_hasher->processed);
+}
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QString>
+
+#include "pooljob.h"
+
+class FileHasher;
+
+/** @returns the algorithm behind names such as "sha256", "sha3-512" or "blake2b-256", nothing for unknown names. */
+std::optional<QCryptographicHash::Algorithm> checksumAlgorithm(const QString &name);
+
+/**
+ * Computes the digest of a local file on the WorkStealingPool, without any of its content leaving the helper.
+ * The number of bytes hashed so far is reported as KJob::Bytes.
+ */
+class ChecksumJob : public PoolJob
+{
+    Q_OBJECT
+public:
+    ChecksumJob(const QByteArray &path, QCryptographicHash::Algorithm algorithm, QObject *parent = nullptr);
+    ~ChecksumJob() override;
+
+    /** Valid once the job finished without error. */
+    [[nodiscard]] QByteArray digest() const;
+
+protected:
+    void updateProgress() override;
+
+private:
+    ChecksumJob(const std::shared_ptr<FileHasher> &hasher, QObject *parent);
+
+    const std::shared_ptr<FileHasher> m_hasher;
+};
@@ -3,8 +3,12 @@
 
 #include "chmodcommand.h"
 
+#include <QFile>
+
 #include <KIO/SimpleJob>
 
+#include "treeattributesjob.h"
+
 ChmodCommand::ChmodCommand(const QUrl &url, int permissions, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
     : BusObject(remoteService, objectPath, parent)
     , m_url(url)
@@ -12,6 +16,24 @@ ChmodCommand::ChmodCommand(const QUrl &url, int permissions, const QString &remo
 {
 }
 
+ChmodCommand::ChmodCommand(const QUrl &url,
+                           int permissions,
+                           int fileMask,
+                           int directoryMask,
+                           bool recursive,
+                           const QString &remoteService,
+                           const QDBusObjectPath &objectPath,
+                           QObject *parent)
+    : BusObject(remoteService, objectPath, parent)
+    , m_url(url)
+    , m_permissions(permissions)
+    , m_tree(true)
+    , m_fileMask(fileMask)
+    , m_directoryMask(directoryMask)
+    , m_recursive(recursive)
+{
+}
+
 void ChmodCommand::start()
 {
     if (!isAuthorized()) {
@@ -19,9 +41,52 @@ void ChmodCommand::start()
         return;
     }
 
+    if (m_tree) {
+        startTree();
+        return;
+    }
+
     auto job = KIO::chmod(m_url, m_permissions);
     setParent(job);
     connect(job, &KIO::SimpleJob::result, this, [this, job](KJob *) {
         sendSignal(&ChmodCommand::result, job->error(), job->errorString());
     });
 }
+
+void ChmodCommand::startTree()
+{
+    if (!m_url.isLocalFile()) {
+        finishEarly(KIO::ERR_UNSUPPORTED_ACTION, m_url.toString());
+        return;
+    }
+
+    AttributeChange change;
+    change.permissions = m_permissions & 07777;
+    change.fileMask = m_fileMask & 07777;
+    change.directoryMask = m_directoryMask & 07777;
+    auto job = new TreeAttributesJob(QFile::encodeName(m_url.toLocalFile()), change, m_recursive);
+    setParent(job);
+    connect(job, &KJob::processedAmountChanged, this, [this](KJob *, KJob::Unit unit, qulonglong amount) {
+        if (unit == KJob::Files) {
+            sendSignal(&ChmodCommand::processedItems, amount);
+        }
+    });
+    connect(job, &TreeAttributesJob::failures, this, [this](const QStringList &paths, const QList<int> &errors) {
+        sendSignal(&ChmodCommand::failures, paths, errors);
+    });
+    connect(job, &KJob::result, this, [this, job](KJob *) {
+        sendSignal(&ChmodCommand::result, job->error(), job->errorString());
+    });
+    job->start();
+}
+
+void ChmodCommand::finishEarly(int error, const QString &errorString)
+{
+    sendSignal(&ChmodCommand::result, error, errorString);
+    deleteLater();
+}
+
+void ChmodCommand::kill()
+{
+    doKill();
+}
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <QList>
+#include <QStringList>
 #include <QUrl>
 
 #include "busobject.h"
@@ -13,14 +15,36 @@ class ChmodCommand : public BusObject
     Q_CLASSINFO("D-Bus Interface", "org.kde.kio.admin.ChmodCommand")
 public:
     explicit ChmodCommand(const QUrl &url, int permissions, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent = nullptr);
+    /**
+     * Tree variant: permissions are applied through the masks, (mode & ~mask) | (permissions & mask), and to everything
+     * below @p url when @p recursive.
+     */
+    explicit ChmodCommand(const QUrl &url,
+                          int permissions,
+                          int fileMask,
+                          int directoryMask,
+                          bool recursive,
+                          const QString &remoteService,
+                          const QDBusObjectPath &objectPath,
+                          QObject *parent = nullptr);
 
 public Q_SLOTS:
     void start();
+    void kill();
 
 Q_SIGNALS:
+    void processedItems(qulonglong items);
+    void failures(const QStringList &paths, const QList<int> &errors);
     void result(int error, const QString &errorString);
 
 private:
+    void startTree();
+    void finishEarly(int error, const QString &errorString);
+
     const QUrl m_url;
     const int m_permissions;
+    const bool m_tree = false;
+    const int m_fileMask = 07777;
+    const int m_directoryMask = 07777;
+    const bool m_recursive = false;
 };
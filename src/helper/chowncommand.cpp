@@ -3,11 +3,29 @@
 
 #include "chowncommand.h"
 
+#include <QFile>
+
 #include <KIO/SimpleJob>
 
+#include "treeattributesjob.h"
+
+ChownCommand::ChownCommand(const QUrl &url,
+                           const QString &user,
+                           const QString &group,
+                           const QString &remoteService,
+                           const QDBusObjectPath &objectPath,
+                           QObject *parent)
+    : BusObject(remoteService, objectPath, parent)
+    , m_url(url)
+    , m_user(user)
+    , m_group(group)
+{
+}
+
 ChownCommand::ChownCommand(const QUrl &url,
                            const QString &user,
                            const QString &group,
+                           bool recursive,
                            const QString &remoteService,
                            const QDBusObjectPath &objectPath,
                            QObject *parent)
@@ -15,6 +33,8 @@ ChownCommand::ChownCommand(const QUrl &url,
     , m_url(url)
     , m_user(user)
     , m_group(group)
+    , m_tree(true)
+    , m_recursive(recursive)
 {
 }
 
@@ -25,9 +45,52 @@ void ChownCommand::start()
         return;
     }
 
+    if (m_tree) {
+        startTree();
+        return;
+    }
+
     auto job = KIO::chown(m_url, m_user, m_group);
     setParent(job);
     connect(job, &KIO::SimpleJob::result, this, [this, job](KJob *) {
         sendSignal(&ChownCommand::result, job->error(), job->errorString());
     });
 }
+
+void ChownCommand::startTree()
+{
+    if (!m_url.isLocalFile()) {
+        finishEarly(KIO::ERR_UNSUPPORTED_ACTION, m_url.toString());
+        return;
+    }
+
+    AttributeChange change;
+    change.user = m_user;
+    change.group = m_group;
+
+    auto job = new TreeAttributesJob(QFile::encodeName(m_url.toLocalFile()), change, m_recursive);
+    setParent(job);
+    connect(job, &KJob::processedAmountChanged, this, [this](KJob *, KJob::Unit unit, qulonglong amount) {
+        if (unit == KJob::Files) {
+            sendSignal(&ChownCommand::processedItems, amount);
+        }
+    });
+    connect(job, &TreeAttributesJob::failures, this, [this](const QStringList &paths, const QList<int> &errors) {
+        sendSignal(&ChownCommand::failures, paths, errors);
+    });
+    connect(job, &KJob::result, this, [this, job](KJob *) {
+        sendSignal(&ChownCommand::result, job->error(), job->errorString());
+    });
+    job->start();
+}
+
+void ChownCommand::finishEarly(int error, const QString &errorString)
+{
+    sendSignal(&ChownCommand::result, error, errorString);
+    deleteLater();
+}
+
+void ChownCommand::kill()
+{
+    doKill();
+}
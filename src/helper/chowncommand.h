@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <QList>
+#include <QStringList>
 #include <QUrl>
 
 #include "busobject.h"
@@ -18,15 +20,31 @@ public:
                           const QString &remoteService,
                           const QDBusObjectPath &objectPath,
                           QObject *parent = nullptr);
+    /** Tree variant: the names are resolved once and applied to everything below @p url when @p recursive. */
+    explicit ChownCommand(const QUrl &url,
+                          const QString &user,
+                          const QString &group,
+                          bool recursive,
+                          const QString &remoteService,
+                          const QDBusObjectPath &objectPath,
+                          QObject *parent = nullptr);
 
 public Q_SLOTS:
     void start();
+    void kill();
 
 Q_SIGNALS:
+    void processedItems(qulonglong items);
+    void failures(const QStringList &paths, const QList<int> &errors);
     void result(int error, const QString &errorString);
 
 private:
+    void startTree();
+    void finishEarly(int error, const QString &errorString);
+
     const QUrl m_url;
     const QString m_user;
     const QString m_group;
+    const bool m_tree = false;
+    const bool m_recursive = false;
 };
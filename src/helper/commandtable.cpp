@@ -0,0 +1,342 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "commandtable.h"
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusMetaType>
+#include <QMetaMethod>
+
+#include <QPointer>
+#include <utility>
+
+#include "busobject.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+// Generous for any sane client, a worker lists, stats and copies one thing at a time.
+constexpr int maximumCommandsPerClient = 256;
+constexpr int maximumFilesPerClient = 64;
+constexpr qint64 maximumBufferedBytesPerClient = 64 * 1024 * 1024;
+// Commands that only move when called and haven't been for this long have been forgotten by their client.
+constexpr auto idleTimeout = 10min;
+constexpr auto idleCheckInterval = 1min;
+
+// QMetaObject::metacall takes the return value plus at most this many arguments, more than any command slot has.
+constexpr qsizetype maximumArguments = 10;
+
+std::optional<QMetaMethod> findSlot(const QMetaObject *metaObject, const QString &name, qsizetype argumentCount)
+{
+    // Only slots the command declares itself, nothing inherited from QObject or BusObject.
+    for (auto i = BusObject::staticMetaObject.methodCount(); i < metaObject->methodCount(); ++i) {
+        const auto method = metaObject->method(i);
+        if (method.methodType() == QMetaMethod::Slot && method.access() == QMetaMethod::Public && method.parameterCount() == argumentCount
+            && QLatin1String(method.name()) == name) {
+            return method;
+        }
+    }
+    return std::nullopt;
+}
+
+/** Brings a D-Bus argument into the type a slot expects, demarshalling custom types. */
+std::optional<QVariant> toParameter(const QVariant &argument, QMetaType type)
+{
+    if (argument.metaType() == type) {
+        return argument;
+    }
+    if (argument.metaType() == QMetaType::fromType<QDBusArgument>()) {
+        QVariant value(type);
+        if (!QDBusMetaType::demarshall(argument.value<QDBusArgument>(), type, value.data())) {
+            return std::nullopt;
+        }
+        return value;
+    }
+    auto value = argument;
+    if (!value.convert(type)) {
+        return std::nullopt;
+    }
+    return value;
+}
+} // namespace
+
+CommandTable &CommandTable::instance()
+{
+    // Never destroyed, commands still alive at exit detach from it in their destructors.
+    static auto table = new CommandTable;
+    return *table;
+}
+
+CommandTable::CommandTable()
+{
+    m_peerWatcher.setConnection(QDBusConnection::systemBus());
+    m_peerWatcher.setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+    connect(&m_peerWatcher, &QDBusServiceWatcher::serviceUnregistered, this, [this](const QString &peer) {
+        qCDebug(KIOADMIN_LOG) << "Reaping the commands of" << peer;
+        reap([&peer](const Slot &slot) {
+            return slot.peer == peer;
+        });
+    });
+
+    m_idleTimer.setInterval(idleCheckInterval);
+    connect(&m_idleTimer, &QTimer::timeout, this, [this] {
+        const auto deadline = std::chrono::steady_clock::now() - idleTimeout;
+        reap([deadline](const Slot &slot) {
+            return slot.lastActivity < deadline && slot.command->isIdle();
+        });
+    });
+}
+
+QString CommandTable::commonInterface()
+{
+    return QStringLiteral("org.kde.kio.admin.Command");
+}
+
+QString CommandTable::basePath()
+{
+    return QStringLiteral("/org/kde/kio/admin");
+}
+
+std::optional<QDBusObjectPath> CommandTable::reserve(const QString &kind, const QString &peer, Resource resource)
+{
+    auto &usage = m_usage[peer];
+    if (usage.commands >= maximumCommandsPerClient || (resource == Resource::File && usage.files >= maximumFilesPerClient)) {
+        qCWarning(KIOADMIN_LOG) << peer << "is at its limit of" << usage.commands << "commands and" << usage.files << "files";
+        forgetIfUnused(peer);
+        return std::nullopt;
+    }
+    if (usage.commands == 0 && usage.bufferedBytes == 0) {
+        m_peerWatcher.addWatchedService(peer);
+    }
+    ++usage.commands;
+    if (resource == Resource::File) {
+        ++usage.files;
+    }
+
+    quint32 index = 0;
+    if (!m_free.empty()) {
+        index = m_free.back();
+        m_free.pop_back();
+    } else {
+        index = quint32(m_slots.size());
+        m_slots.emplace_back();
+    }
+    auto &slot = m_slots.at(index);
+    slot.reserved = true;
+    slot.peer = peer;
+    slot.resource = resource;
+    slot.lastActivity = std::chrono::steady_clock::now();
+    return QDBusObjectPath(QStringLiteral("%1/%2/%3_%4").arg(basePath(), kind, QString::number(index), QString::number(slot.generation)));
+}
+
+void CommandTable::attach(const QDBusObjectPath &path, BusObject *command)
+{
+    const auto index = resolve(path.path());
+    Q_ASSERT(index);
+    if (!index) {
+        return;
+    }
+    auto &slot = m_slots.at(*index);
+    Q_ASSERT(slot.reserved && !slot.command);
+    slot.command = command;
+    if (++m_size == 1) {
+        m_idleTimer.start();
+        Q_EMIT occupied();
+    }
+}
+
+void CommandTable::detach(const QDBusObjectPath &path)
+{
+    const auto index = resolve(path.path());
+    if (!index) {
+        return;
+    }
+    auto &slot = m_slots.at(*index);
+    const bool wasAttached = slot.command;
+    if (wasAttached) {
+        --m_size;
+    }
+    auto &usage = m_usage[slot.peer];
+    --usage.commands;
+    if (slot.resource == Resource::File) {
+        --usage.files;
+    }
+    forgetIfUnused(std::exchange(slot.peer, QString()));
+
+    slot.command = nullptr;
+    slot.reserved = false;
+    ++slot.generation;
+    m_free.push_back(*index);
+    if (wasAttached && m_size == 0) {
+        m_idleTimer.stop();
+        Q_EMIT emptied();
+    }
+}
+
+bool CommandTable::acquireBuffer(const QString &peer, qint64 bytes)
+{
+    auto &usage = m_usage[peer];
+    if (usage.bufferedBytes + bytes > maximumBufferedBytesPerClient) {
+        qCWarning(KIOADMIN_LOG) << peer << "is at its limit of" << usage.bufferedBytes << "buffered bytes";
+        forgetIfUnused(peer);
+        return false;
+    }
+    usage.bufferedBytes += bytes;
+    return true;
+}
+
+void CommandTable::releaseBuffer(const QString &peer, qint64 bytes)
+{
+    if (auto it = m_usage.find(peer); it != m_usage.end()) {
+        it->bufferedBytes -= bytes;
+        Q_ASSERT(it->bufferedBytes >= 0);
+        forgetIfUnused(peer);
+    }
+}
+
+size_t CommandTable::size() const
+{
+    return m_size;
+}
+
+QHash<QString, CommandTable::Usage> CommandTable::usage() const
+{
+    return m_usage;
+}
+
+void CommandTable::forgetIfUnused(const QString &peer)
+{
+    if (auto it = m_usage.find(peer); it != m_usage.end() && it->commands == 0 && it->bufferedBytes == 0) {
+        m_usage.erase(it);
+        m_peerWatcher.removeWatchedService(peer);
+    }
+}
+
+void CommandTable::reap(const std::function<bool(const Slot &slot)> &predicate)
+{
+    // Reaping may destroy commands and thus touch the table, collect first.
+    QList<QPointer<BusObject>> commands;
+    for (const auto &slot : m_slots) {
+        if (slot.command && predicate(slot)) {
+            commands.append(slot.command);
+        }
+    }
+    for (const auto &command : commands) {
+        if (command) {
+            command->reap();
+        }
+    }
+}
+
+std::optional<quint32> CommandTable::resolve(const QString &path) const
+{
+    // basePath/kind/index_generation
+    const auto name = QStringView(path).mid(path.lastIndexOf(QLatin1Char('/')) + 1);
+    const auto separator = name.indexOf(QLatin1Char('_'));
+    if (!path.startsWith(basePath() + QLatin1Char('/')) || separator < 0) {
+        return std::nullopt;
+    }
+    bool indexOk = false;
+    bool generationOk = false;
+    const auto index = name.left(separator).toUInt(&indexOk);
+    const auto generation = name.mid(separator + 1).toUInt(&generationOk);
+    if (!indexOk || !generationOk || index >= m_slots.size()) {
+        return std::nullopt;
+    }
+    const auto &slot = m_slots.at(index);
+    if (!slot.reserved || slot.generation != generation) {
+        return std::nullopt;
+    }
+    return index;
+}
+
+bool CommandTable::handleCommonMessage(BusObject *command, const QDBusMessage &message, const QDBusConnection &connection)
+{
+    const auto arguments = message.arguments();
+    if (message.member() != QLatin1String("setDeadline") || arguments.size() != 1) {
+        return false;
+    }
+    bool ok = false;
+    const auto deadline = arguments.at(0).toLongLong(&ok);
+    if (!ok) {
+        connection.send(message.createErrorReply(QDBusError::InvalidArgs, message.member()));
+        return true;
+    }
+
+    const auto replied = command->dispatch(message, connection, [command, deadline] {
+        command->setDeadline(deadline);
+    });
+    if (!replied && message.isReplyRequired()) {
+        connection.send(message.createReply());
+    }
+    return true;
+}
+
+QString CommandTable::introspect(const QString &path) const
+{
+    // The bus policy doesn't let anyone introspect us anyway, clients use generated interfaces.
+    Q_UNUSED(path);
+    return {};
+}
+
+bool CommandTable::handleMessage(const QDBusMessage &message, const QDBusConnection &connection)
+{
+    const auto index = resolve(message.path());
+    BusObject *command = index ? m_slots.at(*index).command : nullptr;
+    if (!command) {
+        connection.send(message.createErrorReply(QDBusError::UnknownObject, message.path()));
+        return true;
+    }
+    m_slots.at(*index).lastActivity = std::chrono::steady_clock::now();
+    if (command->isExpired()) {
+        // On its way out, the client gave up on it anyway.
+        connection.send(message.createErrorReply(QDBusError::TimedOut, message.path()));
+        return true;
+    }
+    if (message.interface() == commonInterface()) {
+        return handleCommonMessage(command, message, connection);
+    }
+
+    const auto metaObject = command->metaObject();
+    const auto interface = QLatin1String(metaObject->classInfo(metaObject->indexOfClassInfo("D-Bus Interface")).value());
+    if (!message.interface().isEmpty() && message.interface() != interface) {
+        return false;
+    }
+
+    const auto arguments = message.arguments();
+    const auto method = findSlot(metaObject, message.member(), arguments.size());
+    if (!method || arguments.size() > maximumArguments) {
+        return false;
+    }
+
+    QList<QVariant> parameters;
+    parameters.reserve(arguments.size());
+    for (qsizetype i = 0; i < arguments.size(); ++i) {
+        auto parameter = toParameter(arguments.at(i), method->parameterMetaType(int(i)));
+        if (!parameter) {
+            connection.send(message.createErrorReply(QDBusError::InvalidArgs, message.member()));
+            return true;
+        }
+        parameters.append(std::move(*parameter));
+    }
+
+    QVariant returnValue;
+    if (method->returnMetaType() != QMetaType::fromType<void>()) {
+        returnValue = QVariant(method->returnMetaType());
+    }
+    void *argv[maximumArguments + 1] = {returnValue.isValid() ? returnValue.data() : nullptr};
+    for (qsizetype i = 0; i < parameters.size(); ++i) {
+        argv[i + 1] = parameters[i].data();
+    }
+
+    const auto replied = command->dispatch(message, connection, [command, method, &argv] {
+        QMetaObject::metacall(command, QMetaObject::InvokeMetaMethod, method->methodIndex(), argv);
+    });
+    if (!replied && message.isReplyRequired()) {
+        connection.send(returnValue.isValid() ? message.createReply(returnValue) : message.createReply());
+    }
+    return true;
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include <QDBusObjectPath>
+#include <QDBusServiceWatcher>
+#include <QDBusVirtualObject>
+#include <QHash>
+#include <QTimer>
+
+class BusObject;
+
+/**
+ * Dispatches all calls to command objects below /org/kde/kio/admin.
+ *
+ * Rather than registering every command with the connection, commands occupy a slot in a table and their path names
+ * the slot along with its generation. Creation and lookup are O(1), and a slot is reclaimed as soon as its command is
+ * destroyed. A path that outlives its command, or a slot's earlier generation, no longer resolves. Commands manage their
+ * own lifetime as before, the table never owns them.
+ *
+ * The table also keeps book per client, i.e. the peer a command reports to. Clients are capped in how many commands and
+ * files they may have open and how much data the helper may buffer for them. Commands of a client that leaves the bus
+ * get reaped, as do idle commands nobody called for a long time.
+ */
+class CommandTable : public QDBusVirtualObject
+{
+    Q_OBJECT
+public:
+    enum class Resource { Command, File };
+
+    struct Usage {
+        int commands = 0;
+        int files = 0;
+        qint64 bufferedBytes = 0;
+    };
+
+    static CommandTable &instance();
+    static QString basePath();
+    /** Methods every command has, on top of its own interface. Just setDeadline(qlonglong) for now. */
+    static QString commonInterface();
+
+    /**
+     * @returns a fresh path for a command of \a kind on behalf of \a peer, nothing when \a peer is at its limit.
+     * The command claims the path upon construction. Files count against the file limit as well.
+     */
+    std::optional<QDBusObjectPath> reserve(const QString &kind, const QString &peer, Resource resource = Resource::Command);
+    void attach(const QDBusObjectPath &path, BusObject *command);
+    void detach(const QDBusObjectPath &path);
+
+    /** Accounts for data held on behalf of \a peer. @returns false when that would exceed its limit. */
+    bool acquireBuffer(const QString &peer, qint64 bytes);
+    void releaseBuffer(const QString &peer, qint64 bytes);
+
+    /** Commands currently alive. */
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] QHash<QString, Usage> usage() const;
+
+    QString introspect(const QString &path) const override;
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override;
+
+Q_SIGNALS:
+    /** The first command came to life. */
+    void occupied();
+    /** The last command went away. */
+    void emptied();
+
+private:
+    CommandTable();
+
+    struct Slot {
+        quint32 generation = 0;
+        bool reserved = false;
+        BusObject *command = nullptr;
+        QString peer;
+        Resource resource = Resource::Command;
+        std::chrono::steady_clock::time_point lastActivity;
+    };
+
+    /** @returns the index of the slot \a path names, if it is still the same generation. */
+    std::optional<quint32> resolve(const QString &path) const;
+    bool handleCommonMessage(BusObject *command, const QDBusMessage &message, const QDBusConnection &connection);
+    void reap(const std::function<bool(const Slot &slot)> &predicate);
+    void forgetIfUnused(const QString &peer);
+
+    std::vector<Slot> m_slots;
+    std::vector<quint32> m_free;
+    size_t m_size = 0;
+    QHash<QString, Usage> m_usage;
+    QDBusServiceWatcher m_peerWatcher;
+    QTimer m_idleTimer;
+};
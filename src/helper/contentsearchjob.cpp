@@ -0,0 +1,296 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "contentsearchjob.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <QRegularExpression>
+
+#include <KIO/Global>
+
+#include "fsutil.h"
+
+namespace
+{
+// Files are read in blocks of whole lines. Reading rather than mapping them, a log truncated while we are looking at
+// it would get us a SIGBUS otherwise.
+constexpr size_t blockSize = 1024 * 1024;
+// A file with a NUL byte in its beginning is binary, same as grep thinks.
+constexpr size_t binaryProbeSize = 8192;
+// Minified files or logs without newlines make for huge lines, nobody wants megabytes of context.
+constexpr qsizetype maxLineLength = 1024;
+} // namespace
+
+class ContentSearcher : public PoolOperation
+{
+public:
+    ContentSearcher(const QByteArray &path, const ContentQuery &query)
+        : m_path(path)
+        , m_query(query)
+    {
+        if (!query.regularExpression && !query.caseInsensitive) {
+            m_literal = query.pattern.toUtf8();
+        }
+    }
+
+    std::atomic<qulonglong> scannedFiles = 0;
+
+    struct Matches {
+        QStringList paths;
+        QList<qulonglong> lineNumbers;
+        QStringList lines;
+    };
+
+    Matches takeMatches()
+    {
+        std::lock_guard lock(m_mutex);
+        return std::exchange(m_matches, {});
+    }
+
+protected:
+    void run() override
+    {
+        if (m_literal.isEmpty()) {
+            const auto regularExpression = makeRegularExpression();
+            if (!regularExpression.isValid()) {
+                fail(KIO::ERR_WORKER_DEFINED, regularExpression.errorString().toUtf8());
+                return;
+            }
+        }
+
+        struct stat stat {
+        };
+        if (fstatat(AT_FDCWD, m_path.constData(), &stat, 0) != 0) {
+            fail(errnoToKIOError(errno, KIO::ERR_DOES_NOT_EXIST), m_path);
+            return;
+        }
+        if (S_ISREG(stat.st_mode)) {
+            scan(AT_FDCWD, m_path, m_path);
+            return;
+        }
+        auto fd = std::make_shared<UniqueFd>(open(m_path.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        if (!fd->isValid()) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_ENTER_DIRECTORY), m_path);
+            return;
+        }
+        walk(fd, m_path);
+    }
+
+private:
+    // Shared instances don't make for concurrent matching, every file gets its own. Compiling is cheap next to reading.
+    [[nodiscard]] QRegularExpression makeRegularExpression() const
+    {
+        const auto pattern = m_query.regularExpression ? m_query.pattern : QRegularExpression::escape(m_query.pattern);
+        return QRegularExpression(pattern, m_query.caseInsensitive ? QRegularExpression::CaseInsensitiveOption : QRegularExpression::NoPatternOption);
+    }
+
+    void walk(const std::shared_ptr<UniqueFd> &directoryFd, const QByteArray &directoryPath)
+    {
+        std::vector<DirectoryEntry> entries;
+        if (!readDirectory(directoryFd->get(), entries)) {
+            return;
+        }
+
+        for (const auto &entry : entries) {
+            if (isCanceled()) {
+                return;
+            }
+            auto type = entry.type;
+            if (type == DT_UNKNOWN) {
+                struct stat stat {
+                };
+                if (fstatat(directoryFd->get(), entry.name.constData(), &stat, AT_SYMLINK_NOFOLLOW) != 0) {
+                    continue;
+                }
+                type = IFTODT(stat.st_mode);
+            }
+
+            const auto path = joinPath(directoryPath, entry.name);
+            if (type == DT_DIR) {
+                schedule([self = sharedSelf<ContentSearcher>(), directoryFd, name = entry.name, path] {
+                    constexpr auto flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+                    auto fd = std::make_shared<UniqueFd>(openat(directoryFd->get(), name.constData(), flags));
+                    if (fd->isValid()) {
+                        self->walk(fd, path);
+                    }
+                });
+            } else if (type == DT_REG && (m_query.fileGlob.isEmpty() || fnmatch(m_query.fileGlob.constData(), entry.name.constData(), 0) == 0)) {
+                schedule([self = sharedSelf<ContentSearcher>(), directoryFd, name = entry.name, path] {
+                    self->scan(directoryFd->get(), name, path);
+                });
+            }
+        }
+    }
+
+    void scan(int directoryFd, const QByteArray &name, const QByteArray &path)
+    {
+        UniqueFd fd(openat(directoryFd, name.constData(), O_RDONLY | O_NOFOLLOW | O_NOCTTY | O_CLOEXEC));
+        struct stat stat {
+        };
+        if (!fd.isValid() || fstat(fd.get(), &stat) != 0 || !S_ISREG(stat.st_mode)) {
+            return;
+        }
+        posix_fadvise(fd.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+        ++scannedFiles;
+
+        std::optional<QRegularExpression> regularExpression;
+        if (m_literal.isEmpty()) {
+            regularExpression = makeRegularExpression();
+        }
+        const auto displayPath = QFile::decodeName(path);
+
+        std::vector<char> buffer(blockSize);
+        size_t filled = 0;
+        qulonglong lineNumber = 1;
+        bool probed = false;
+        while (!isCanceled()) {
+            const auto length = read(fd.get(), buffer.data() + filled, buffer.size() - filled);
+            if (length < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            filled += length;
+            const bool atEnd = length == 0;
+
+            if (!probed && (filled >= binaryProbeSize || atEnd)) {
+                probed = true;
+                if (memchr(buffer.data(), '\0', std::min(filled, binaryProbeSize))) {
+                    return;
+                }
+            }
+
+            // Only whole lines are scanned, unless a single line fills the entire buffer.
+            const char *blockEnd = buffer.data() + filled;
+            if (!atEnd) {
+                const auto newline = static_cast<const char *>(memrchr(buffer.data(), '\n', filled));
+                if (newline) {
+                    blockEnd = newline + 1;
+                } else if (filled < buffer.size()) {
+                    continue;
+                }
+            }
+            if (!probed) {
+                continue;
+            }
+
+            const bool carryOn = regularExpression ? scanLines(buffer.data(), blockEnd, *regularExpression, displayPath, lineNumber)
+                                                   : scanLiteral(buffer.data(), blockEnd, displayPath, lineNumber);
+            if (!carryOn || atEnd) {
+                return;
+            }
+            filled = buffer.data() + filled - blockEnd;
+            memmove(buffer.data(), blockEnd, filled);
+        }
+    }
+
+    // Both scanners advance lineNumber past the block. They return false once the search is over.
+    bool scanLiteral(const char *begin, const char *end, const QString &path, qulonglong &lineNumber)
+    {
+        const char *countedUpTo = begin;
+        for (const char *position = begin; position < end;) {
+            const auto hit = static_cast<const char *>(memmem(position, end - position, m_literal.constData(), m_literal.size()));
+            if (!hit) {
+                break;
+            }
+            const auto previousNewline = static_cast<const char *>(memrchr(countedUpTo, '\n', hit - countedUpTo));
+            const auto lineBegin = previousNewline ? previousNewline + 1 : countedUpTo;
+            lineNumber += std::count(countedUpTo, lineBegin, '\n');
+            const auto newline = static_cast<const char *>(memchr(hit, '\n', end - hit));
+            const auto lineEnd = newline ? newline : end;
+            if (!addMatch(path, lineNumber, lineBegin, lineEnd)) {
+                return false;
+            }
+            if (!newline) {
+                return true; // The line goes on in the next block.
+            }
+            position = countedUpTo = newline + 1;
+            ++lineNumber;
+        }
+        lineNumber += std::count(countedUpTo, end, '\n');
+        return true;
+    }
+
+    bool scanLines(const char *begin, const char *end, const QRegularExpression &regularExpression, const QString &path, qulonglong &lineNumber)
+    {
+        for (const char *lineBegin = begin; lineBegin < end;) {
+            const auto newline = static_cast<const char *>(memchr(lineBegin, '\n', end - lineBegin));
+            const auto lineEnd = newline ? newline : end;
+            if (regularExpression.match(QString::fromUtf8(lineBegin, lineEnd - lineBegin)).hasMatch() && !addMatch(path, lineNumber, lineBegin, lineEnd)) {
+                return false;
+            }
+            if (!newline) {
+                break;
+            }
+            lineBegin = newline + 1;
+            ++lineNumber;
+        }
+        return !isCanceled();
+    }
+
+    bool addMatch(const QString &path, qulonglong lineNumber, const char *begin, const char *end)
+    {
+        const auto index = m_found++;
+        if (m_query.maxResults > 0 && index >= qulonglong(m_query.maxResults)) {
+            return false; // Someone else got the last one.
+        }
+        if (end > begin && end[-1] == '\r') {
+            --end;
+        }
+        const auto line = QString::fromUtf8(begin, std::min<qsizetype>(end - begin, maxLineLength));
+        {
+            std::lock_guard lock(m_mutex);
+            m_matches.paths.append(path);
+            m_matches.lineNumbers.append(lineNumber);
+            m_matches.lines.append(line);
+        }
+        if (m_query.maxResults > 0 && index + 1 == qulonglong(m_query.maxResults)) {
+            cancel();
+            return false;
+        }
+        return true;
+    }
+
+    const QByteArray m_path;
+    const ContentQuery m_query;
+    // Set for case sensitive literal searches, everything else goes through QRegularExpression.
+    QByteArray m_literal;
+    std::atomic<qulonglong> m_found = 0;
+    Matches m_matches;
+};
+
+ContentSearchJob::ContentSearchJob(const QByteArray &path, const ContentQuery &query, QObject *parent)
+    : ContentSearchJob(std::make_shared<ContentSearcher>(path, query), parent)
+{
+}
+
+ContentSearchJob::ContentSearchJob(const std::shared_ptr<ContentSearcher> &searcher, QObject *parent)
+    : PoolJob(searcher, parent)
+    , m_searcher(searcher)
+{
+}
+
+ContentSearchJob::~ContentSearchJob() = default;
+
+void ContentSearchJob::updateProgress()
+{
+    setProcessedAmount(KJob::Files, m_searcher->scannedFiles);
+    const auto [paths, lineNumbers, lines] = m_searcher->takeMatches();
+    if (!paths.isEmpty()) {
+        Q_EMIT matches(paths, lineNumbers, lines);
+    }
+}
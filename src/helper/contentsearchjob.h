@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <memory>
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "pooljob.h"
+
+class ContentSearcher;
+
+struct ContentQuery {
+    /** Shell glob file names have to match. Empty matches every file. */
+    QByteArray fileGlob;
+    QString pattern;
+    bool regularExpression = false;
+    bool caseInsensitive = false;
+    /** The search stops once this many lines matched. 0 for no limit. */
+    qsizetype maxResults = 0;
+};
+
+/**
+ * Searches the content of all regular files within a local directory tree, like grep -r.
+ *
+ * Directories are walked and files are scanned in parallel on the WorkStealingPool, reading them in large blocks of
+ * whole lines. Case sensitive literal patterns are found with memmem, which glibc implements with vector instructions;
+ * everything else is matched line by line with QRegularExpression. Files that look binary are skipped, as are unreadable
+ * ones. Matching lines are delivered in batches through matches().
+ */
+class ContentSearchJob : public PoolJob
+{
+    Q_OBJECT
+public:
+    ContentSearchJob(const QByteArray &path, const ContentQuery &query, QObject *parent = nullptr);
+    ~ContentSearchJob() override;
+
+Q_SIGNALS:
+    void matches(const QStringList &paths, const QList<qulonglong> &lineNumbers, const QStringList &lines);
+
+protected:
+    void updateProgress() override;
+
+private:
+    ContentSearchJob(const std::shared_ptr<ContentSearcher> &searcher, QObject *parent);
+
+    const std::shared_ptr<ContentSearcher> m_searcher;
+};
@@ -3,8 +3,14 @@
 
 #include "copycommand.h"
 
+#include <sys/stat.h>
+
+#include <QFile>
+
 #include <KIO/CopyJob>
 
+#include "treecopyjob.h"
+
 CopyCommand::CopyCommand(const QUrl &src,
                          const QUrl &dst,
                          int permissions,
@@ -27,9 +33,37 @@ void CopyCommand::start()
         return;
     }
 
-    auto job = KIO::copy(m_src, m_dst, m_flags);
+    // Trees get copied natively and in parallel, CopyJob would go through them one item at a time. KIO's own CopyJob
+    // never hands us a directory, trees only arrive through the worker's tree copy special.
+    const bool copyTree = isLocalDirectory(m_src) && m_dst.isLocalFile();
+    KJob *job = nullptr;
+    if (copyTree) {
+        job = new TreeCopyJob(QFile::encodeName(m_src.toLocalFile()), QFile::encodeName(m_dst.toLocalFile()), m_flags.testFlag(KIO::Overwrite));
+    } else {
+        job = KIO::copy(m_src, m_dst, m_flags);
+    }
     setParent(job);
-    connect(job, &KIO::CopyJob::result, this, [this, job](KJob *) {
+    connect(job, &KJob::processedAmountChanged, this, [this](KJob *, KJob::Unit unit, qulonglong amount) {
+        if (unit == KJob::Bytes) {
+            sendSignal(&CopyCommand::processedSize, amount);
+        }
+    });
+    connect(job, &KJob::result, this, [this, job](KJob *) {
         sendSignal(&CopyCommand::result, job->error(), job->errorString());
     });
+    if (copyTree) {
+        job->start();
+    }
+}
+
+void CopyCommand::kill()
+{
+    doKill();
+}
+
+bool CopyCommand::isLocalDirectory(const QUrl &url)
+{
+    struct stat stat {
+    };
+    return url.isLocalFile() && ::lstat(QFile::encodeName(url.toLocalFile()).constData(), &stat) == 0 && S_ISDIR(stat.st_mode);
 }
@@ -24,11 +24,15 @@ public:
 
 public Q_SLOTS:
     void start();
+    void kill();
 
 Q_SIGNALS:
+    void processedSize(qulonglong bytes);
     void result(int error, const QString &errorString);
 
 private:
+    static bool isLocalDirectory(const QUrl &url);
+
     const QUrl m_src;
     const QUrl m_dst;
     const int m_permissions;
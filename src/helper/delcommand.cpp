@@ -3,8 +3,12 @@
 
 #include "delcommand.h"
 
+#include <QFile>
+
 #include <KIO/DeleteJob>
 
+#include "treedeletejob.h"
+
 DelCommand::DelCommand(const QUrl &url, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
     : BusObject(remoteService, objectPath, parent)
     , m_url(url)
@@ -18,9 +22,30 @@ void DelCommand::start()
         return;
     }
 
-    auto job = KIO::del(m_url);
+    if (!m_url.isLocalFile()) {
+        auto job = KIO::del(m_url);
+        setParent(job);
+        connect(job, &KIO::DeleteJob::result, this, [this, job](KJob *) {
+            sendSignal(&DelCommand::result, job->error(), job->errorString());
+        });
+        return;
+    }
+
+    // DeleteJob would list the entire tree first and then delete entry by entry. Instead delete natively and in parallel.
+    auto job = new TreeDeleteJob(QFile::encodeName(m_url.toLocalFile()));
     setParent(job);
-    connect(job, &KIO::DeleteJob::result, this, [this, job](KJob *) {
+    connect(job, &KJob::processedAmountChanged, this, [this](KJob *, KJob::Unit unit, qulonglong amount) {
+        if (unit == KJob::Files) {
+            sendSignal(&DelCommand::processedItems, amount);
+        }
+    });
+    connect(job, &KJob::result, this, [this, job](KJob *) {
         sendSignal(&DelCommand::result, job->error(), job->errorString());
     });
+    job->start();
+}
+
+void DelCommand::kill()
+{
+    doKill();
 }
@@ -16,8 +16,10 @@ public:
 
 public Q_SLOTS:
     void start();
+    void kill();
 
 Q_SIGNALS:
+    void processedItems(qulonglong items);
     void result(int error, const QString &errorString);
 
 private:
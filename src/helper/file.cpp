@@ -3,6 +3,8 @@
 
 #include "file.h"
 
+#include <algorithm>
+
 #include <KIO/FileJob>
 
 File::File(const QUrl &url, QIODevice::OpenMode openMode, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
@@ -12,6 +14,11 @@ File::File(const QUrl &url, QIODevice::OpenMode openMode, const QString &remoteS
 {
 }
 
+bool File::isIdle() const
+{
+    return !m_job;
+}
+
 void File::open()
 {
     if (!isAuthorized()) {
@@ -34,6 +41,9 @@ void File::open()
         sendSignal(&File::truncated, length);
     });
     connect(m_job, &KIO::FileJob::written, this, [this](KIO::Job *, qulonglong length) {
+        const auto released = std::min(m_unwritten, qint64(length));
+        m_unwritten -= released;
+        releaseBuffer(released);
         sendSignal(&File::written, length);
     });
     connect(m_job, &KIO::FileJob::position, this, [this](KIO::Job *, qulonglong offset) {
@@ -62,6 +72,12 @@ void File::write(const QByteArray &data)
         sendErrorReply(QDBusError::AccessDenied);
         return;
     }
+    if (!acquireBuffer(data.size())) {
+        sendErrorReply(QDBusError::LimitsExceeded);
+        sendSignal(&File::result, int(KIO::ERR_OUT_OF_MEMORY), m_url.toString());
+        return;
+    }
+    m_unwritten += data.size();
     m_job->write(data);
 }
 
@@ -20,6 +20,9 @@ class File : public BusObject
 public:
     File(const QUrl &url, QIODevice::OpenMode openMode, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent = nullptr);
 
+    /** Only until it got opened. Clients may hold on to an open file for as long as they like, it goes when they leave the bus. */
+    [[nodiscard]] bool isIdle() const override;
+
 public Q_SLOTS:
     void open();
     void read(qulonglong size);
@@ -43,4 +46,6 @@ private:
     KIO::FileJob *m_job = nullptr;
     QUrl m_url;
     QIODevice::OpenMode m_openMode;
+    // Data handed to the job that it hasn't reported written yet.
+    qint64 m_unwritten = 0;
 };
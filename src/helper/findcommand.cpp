@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "findcommand.h"
+
+#include <QFile>
+
+FindCommand::FindCommand(const QUrl &url,
+                         const SearchCriteria &criteria,
+                         KIO::StatDetails details,
+                         const QString &remoteService,
+                         const QDBusObjectPath &objectPath,
+                         QObject *parent)
+    : BusObject(remoteService, objectPath, parent)
+    , m_url(url)
+    , m_criteria(criteria)
+    , m_details(details)
+{
+}
+
+void FindCommand::start()
+{
+    if (!isAuthorized()) {
+        sendErrorReply(QDBusError::AccessDenied);
+        return;
+    }
+
+    if (!m_url.isLocalFile()) {
+        sendSignal(&FindCommand::result, int(KIO::ERR_UNSUPPORTED_ACTION), m_url.toString());
+        deleteLater();
+        return;
+    }
+
+    auto job = new TreeSearchJob(QFile::encodeName(m_url.toLocalFile()), m_criteria, m_details);
+    setParent(job);
+    connect(job, &TreeSearchJob::entries, this, [this](const KIO::UDSEntryList &list) {
+        sendSignal(&FindCommand::entries, list);
+    });
+    connect(job, &KJob::result, this, [this, job](KJob *) {
+        sendSignal(&FindCommand::result, job->error(), job->errorString());
+    });
+    job->start();
+}
+
+void FindCommand::kill()
+{
+    doKill();
+}
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <QUrl>
+
+#include <KIO/UDSEntry>
+
+#include "busobject.h"
+#include "treesearchjob.h"
+
+/** Searches a directory tree and only sends back what matched, see TreeSearchJob. */
+class FindCommand : public BusObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kio.admin.FindCommand")
+public:
+    explicit FindCommand(const QUrl &url,
+                         const SearchCriteria &criteria,
+                         KIO::StatDetails details,
+                         const QString &remoteService,
+                         const QDBusObjectPath &objectPath,
+                         QObject *parent = nullptr);
+
+public Q_SLOTS:
+    void start();
+    void kill();
+
+Q_SIGNALS:
+    void entries(const KIO::UDSEntryList &list);
+    void result(int error, const QString &errorString);
+
+private:
+    const QUrl m_url;
+    const SearchCriteria m_criteria;
+    const KIO::StatDetails m_details;
+};
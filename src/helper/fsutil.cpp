@@ -0,0 +1,248 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "fsutil.h"
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <limits>
+#include <utility>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <KIO/Global>
+
+namespace
+{
+// Not exported by all libc versions we care about, so we spell out the kernel ABI ourselves.
+struct LinuxDirent64 {
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// Large enough to swallow a few hundred entries per syscall.
+constexpr size_t direntBufferSize = 64 * 1024;
+} // namespace
+
+UniqueFd::UniqueFd(int fd)
+    : m_fd(fd)
+{
+}
+
+UniqueFd::~UniqueFd()
+{
+    reset();
+}
+
+UniqueFd::UniqueFd(UniqueFd &&other) noexcept
+    : m_fd(other.m_fd)
+{
+    other.m_fd = -1;
+}
+
+UniqueFd &UniqueFd::operator=(UniqueFd &&other) noexcept
+{
+    if (this != &other) {
+        reset(other.m_fd);
+        other.m_fd = -1;
+    }
+    return *this;
+}
+
+void UniqueFd::reset(int fd)
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_fd = fd;
+}
+
+bool readDirectory(int dirFd, std::vector<DirectoryEntry> &entries)
+{
+    DirectoryPage page;
+    page.entries = std::move(entries);
+    const bool ok = readDirectoryPage(dirFd, 0, std::numeric_limits<size_t>::max(), {}, page);
+    entries = std::move(page.entries);
+    return ok;
+}
+
+bool readDirectoryPage(int dirFd, off64_t cursor, size_t limit, const std::function<bool(const char *name)> &filter, DirectoryPage &page)
+{
+    if (lseek64(dirFd, cursor, SEEK_SET) < 0) {
+        return false;
+    }
+
+    page.nextCursor = cursor;
+    page.atEnd = false;
+    size_t accepted = 0;
+    alignas(LinuxDirent64) std::array<char, direntBufferSize> buffer;
+    while (accepted < limit) {
+        const auto bytes = syscall(SYS_getdents64, dirFd, buffer.data(), buffer.size());
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (bytes == 0) {
+            page.atEnd = true;
+            return true;
+        }
+        for (long offset = 0; offset < bytes && accepted < limit;) {
+            const auto dirent = reinterpret_cast<const LinuxDirent64 *>(buffer.data() + offset);
+            offset += dirent->d_reclen;
+            // d_off is the position right after this entry, where the next page picks up.
+            page.nextCursor = dirent->d_off;
+            if (qstrcmp(dirent->d_name, ".") == 0 || qstrcmp(dirent->d_name, "..") == 0) {
+                continue;
+            }
+            if (filter && !filter(dirent->d_name)) {
+                continue;
+            }
+            page.entries.push_back({QByteArray(dirent->d_name), dirent->d_ino, dirent->d_type});
+            ++accepted;
+        }
+    }
+    return true;
+}
+
+QByteArray joinPath(const QByteArray &directory, const QByteArray &name)
+{
+    if (directory.endsWith('/')) {
+        return directory + name;
+    }
+    return directory + '/' + name;
+}
+
+int errnoToKIOError(int error, int fallback)
+{
+    switch (error) {
+    case ENOENT:
+        return KIO::ERR_DOES_NOT_EXIST;
+    case EACCES:
+    case EPERM:
+        return KIO::ERR_ACCESS_DENIED;
+    case EROFS:
+        return KIO::ERR_WRITE_ACCESS_DENIED;
+    case ENOSPC:
+    case EDQUOT:
+        return KIO::ERR_DISK_FULL;
+    case EEXIST:
+        return KIO::ERR_FILE_ALREADY_EXIST;
+    case EISDIR:
+        return KIO::ERR_IS_DIRECTORY;
+    case ENOTDIR:
+        return KIO::ERR_IS_FILE;
+    case ELOOP:
+        return KIO::ERR_CYCLIC_LINK;
+    case EXDEV:
+        return KIO::ERR_UNSUPPORTED_ACTION;
+    case ECANCELED:
+        return KIO::ERR_USER_CANCELED;
+    case ENOMEM:
+        return KIO::ERR_OUT_OF_MEMORY;
+    default:
+        break;
+    }
+    return fallback;
+}
+
+int renamePath(const QByteArray &src, const QByteArray &dst, unsigned int flags)
+{
+    if (flags == 0) {
+        // renameat2 would replace an empty directory, the file worker never overwrites directories.
+        struct stat stat {
+        };
+        if (lstat(dst.constData(), &stat) == 0 && S_ISDIR(stat.st_mode)) {
+            return KIO::ERR_DIR_ALREADY_EXIST;
+        }
+    }
+    int ret = renameat2(AT_FDCWD, src.constData(), AT_FDCWD, dst.constData(), flags);
+    if (ret != 0 && errno == EINVAL && flags == RENAME_NOREPLACE) {
+        // The filesystem doesn't support the flag. Fall back to what KIO would do.
+        struct stat stat {
+        };
+        if (lstat(dst.constData(), &stat) == 0) {
+            errno = EEXIST;
+        } else {
+            ret = renameat2(AT_FDCWD, src.constData(), AT_FDCWD, dst.constData(), 0);
+        }
+    }
+    if (ret == 0) {
+        return 0;
+    }
+
+    switch (errno) {
+    case EEXIST:
+    case ENOTEMPTY: {
+        struct stat stat {
+        };
+        const bool isDirectory = lstat(dst.constData(), &stat) == 0 && S_ISDIR(stat.st_mode);
+        return isDirectory ? KIO::ERR_DIR_ALREADY_EXIST : KIO::ERR_FILE_ALREADY_EXIST;
+    }
+    case EISDIR:
+        return KIO::ERR_DIR_ALREADY_EXIST;
+    case EINVAL:
+        // Either the filesystem can't exchange or a directory was to be moved into itself.
+        return (flags & RENAME_EXCHANGE) ? KIO::ERR_UNSUPPORTED_ACTION : KIO::ERR_CANNOT_RENAME;
+    default:
+        // EXDEV maps to ERR_UNSUPPORTED_ACTION, which makes KIO fall back to copy and delete.
+        return errnoToKIOError(errno, KIO::ERR_CANNOT_RENAME);
+    }
+}
+
+bool chmodFd(int fd, mode_t mode)
+{
+    if (fchmod(fd, mode) == 0) {
+        return true;
+    }
+    if (errno != EBADF) {
+        return false;
+    }
+    // O_PATH descriptors can't be fchmod'ed. Their /proc link leads to the very file they were opened for.
+    std::array<char, 32> procPath{};
+    snprintf(procPath.data(), procPath.size(), "/proc/self/fd/%d", fd);
+    return chmod(procPath.data(), mode) == 0;
+}
+
+bool chownFd(int fd, uid_t uid, gid_t gid)
+{
+    return fchownat(fd, "", uid, gid, AT_EMPTY_PATH) == 0;
+}
+
+bool isSparse(const struct stat &stat)
+{
+    // st_blocks is in 512 byte units regardless of the filesystem's block size.
+    return S_ISREG(stat.st_mode) && stat.st_blocks * 512 < stat.st_size;
+}
+
+std::optional<DataExtent> nextDataExtent(int fd, off_t offset, off_t size)
+{
+    if (offset >= size) {
+        return std::nullopt;
+    }
+    const auto begin = lseek(fd, offset, SEEK_DATA);
+    if (begin < 0) {
+        if (errno == ENXIO) {
+            return std::nullopt;
+        }
+        return DataExtent{offset, size};
+    }
+    if (begin >= size) {
+        return std::nullopt;
+    }
+    auto end = lseek(fd, begin, SEEK_HOLE);
+    if (end < 0 || end > size) {
+        end = size;
+    }
+    return DataExtent{begin, end};
+}
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include <QByteArray>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+/** Owning wrapper around a file descriptor. */
+class UniqueFd
+{
+public:
+    UniqueFd() = default;
+    explicit UniqueFd(int fd);
+    ~UniqueFd();
+    UniqueFd(UniqueFd &&other) noexcept;
+    UniqueFd &operator=(UniqueFd &&other) noexcept;
+    UniqueFd(const UniqueFd &) = delete;
+    UniqueFd &operator=(const UniqueFd &) = delete;
+
+    [[nodiscard]] int get() const
+    {
+        return m_fd;
+    }
+    [[nodiscard]] bool isValid() const
+    {
+        return m_fd >= 0;
+    }
+    void reset(int fd = -1);
+
+private:
+    int m_fd = -1;
+};
+
+struct DirectoryEntry {
+    QByteArray name;
+    ino64_t inode;
+    /** One of the DT_* constants. May be DT_UNKNOWN depending on the filesystem. */
+    unsigned char type;
+};
+
+/**
+ * Reads all entries of the directory behind @p dirFd using getdents64, skipping "." and "..".
+ * @returns false and leaves errno set when reading failed
+ */
+bool readDirectory(int dirFd, std::vector<DirectoryEntry> &entries);
+
+struct DirectoryPage {
+    std::vector<DirectoryEntry> entries;
+    /** Opaque getdents position to pass as cursor for the next page. */
+    off64_t nextCursor = 0;
+    bool atEnd = false;
+};
+
+/**
+ * Reads up to @p limit entries accepted by @p filter, starting at @p cursor (0 being the start of the directory).
+ * "." and ".." are skipped. Reading stops as soon as the page is full.
+ * @returns false and leaves errno set when reading failed
+ */
+bool readDirectoryPage(int dirFd, off64_t cursor, size_t limit, const std::function<bool(const char *name)> &filter, DirectoryPage &page);
+
+/** Joins a directory path and an entry name. */
+QByteArray joinPath(const QByteArray &directory, const QByteArray &name);
+
+/** Maps an errno value onto the closest KIO::Error. @p fallback is used for everything without an obvious match. */
+int errnoToKIOError(int error, int fallback);
+
+/**
+ * Renames @p src to @p dst with renameat2. @p flags may be RENAME_NOREPLACE or RENAME_EXCHANGE, RENAME_NOREPLACE falls
+ * back to a stat-then-rename on filesystems that don't support it. Without flags a directory at @p dst is never replaced.
+ * @returns 0 or a KIO::Error. ERR_FILE_ALREADY_EXIST and ERR_DIR_ALREADY_EXIST concern @p dst, everything else @p src.
+ */
+int renamePath(const QByteArray &src, const QByteArray &dst, unsigned int flags);
+
+/**
+ * Changes the mode of the file behind @p fd, which may be an O_PATH descriptor. Unlike a chmod by name this can't be
+ * redirected elsewhere by swapping the file for a symlink in the meantime.
+ * @returns false and leaves errno set on failure
+ */
+bool chmodFd(int fd, mode_t mode);
+
+/** Like chmodFd() for ownership. A symlink opened with O_PATH | O_NOFOLLOW gets its own ownership changed. */
+bool chownFd(int fd, uid_t uid, gid_t gid);
+
+/** @returns whether the file behind @p stat has fewer blocks allocated than its size needs, i.e. has holes. */
+bool isSparse(const struct stat &stat);
+
+struct DataExtent {
+    off_t begin;
+    off_t end;
+};
+
+/**
+ * Finds the next range at or after @p offset that holds data, according to SEEK_DATA and SEEK_HOLE. Everything between
+ * @p offset and its begin is a hole and reads as zeros. Filesystems that don't report holes have a single extent up to
+ * @p size.
+ * @returns nothing once only holes remain before @p size
+ */
+std::optional<DataExtent> nextDataExtent(int fd, off_t offset, off_t size);
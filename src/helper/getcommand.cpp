@@ -3,12 +3,28 @@
 
 #include "getcommand.h"
 
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <QMimeDatabase>
+
 #include <KIO/TransferJob>
 
+namespace
+{
+// Same order of magnitude as what KIO's file worker sends per data().
+constexpr off_t sparseChunkSize = 1024 * 1024;
+} // namespace
+
 GetCommand::GetCommand(const QUrl &url, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
     : BusObject(remoteService, objectPath, parent)
     , m_url(url)
 {
+    m_readTimer.setInterval(0);
+    connect(&m_readTimer, &QTimer::timeout, this, &GetCommand::readSparse);
 }
 
 void GetCommand::start()
@@ -18,6 +34,10 @@ void GetCommand::start()
         return;
     }
 
+    if (startSparse()) {
+        return;
+    }
+
     auto job = KIO::get(m_url);
     setParent(job);
     connect(job, &KIO::TransferJob::data, this, [this](KIO::Job *, const QByteArray &blob) {
@@ -31,7 +51,84 @@ void GetCommand::start()
     });
 }
 
+bool GetCommand::isIdle() const
+{
+    return BusObject::isIdle() && !m_fd.isValid();
+}
+
+bool GetCommand::startSparse()
+{
+    if (!m_url.isLocalFile()) {
+        return false;
+    }
+    const auto path = QFile::encodeName(m_url.toLocalFile());
+    // Non-blocking so a FIFO can't freeze the helper before we get to check what we opened.
+    UniqueFd fd(open(path.constData(), O_RDONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC));
+    struct stat stat {
+    };
+    if (!fd.isValid() || fstat(fd.get(), &stat) != 0 || !S_ISREG(stat.st_mode) || !isSparse(stat)) {
+        return false; // Errors are left for KIO::get to report.
+    }
+    fcntl(fd.get(), F_SETFL, fcntl(fd.get(), F_GETFL) & ~O_NONBLOCK);
+
+    m_fd = std::move(fd);
+    m_size = stat.st_size;
+    sendSignal(&GetCommand::mimeTypeFound, QMimeDatabase().mimeTypeForFile(m_url.toLocalFile()).name());
+    m_readTimer.start();
+    return true;
+}
+
+void GetCommand::readSparse()
+{
+    if (m_offset >= m_extentEnd) {
+        const auto extent = nextDataExtent(m_fd.get(), m_offset, m_size);
+        const auto dataBegin = extent ? extent->begin : m_size;
+        if (dataBegin > m_offset) {
+            sendSignal(&GetCommand::hole, qulonglong(dataBegin - m_offset));
+            m_offset = dataBegin;
+        }
+        if (!extent) {
+            finishSparse(KJob::NoError, QString());
+            return;
+        }
+        m_extentEnd = extent->end;
+    }
+
+    QByteArray blob(std::min(m_extentEnd - m_offset, sparseChunkSize), Qt::Uninitialized);
+    const auto length = pread(m_fd.get(), blob.data(), blob.size(), m_offset);
+    if (length < 0) {
+        if (errno != EINTR) {
+            finishSparse(errnoToKIOError(errno, KIO::ERR_CANNOT_READ), m_url.toLocalFile());
+        }
+        return;
+    }
+    if (length == 0) {
+        finishSparse(KJob::NoError, QString()); // The file shrank while we were at it.
+        return;
+    }
+    blob.truncate(length);
+    m_offset += length;
+    sendSignal(&GetCommand::data, blob);
+}
+
+void GetCommand::finishSparse(int error, const QString &errorString)
+{
+    m_readTimer.stop();
+    m_fd.reset();
+    sendSignal(&GetCommand::result, error, errorString);
+    deleteLater();
+}
+
 void GetCommand::kill()
 {
+    if (m_readTimer.isActive()) {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return;
+        }
+        m_readTimer.stop();
+        deleteLater();
+        return;
+    }
     doKill();
 }
@@ -3,9 +3,11 @@
 
 #pragma once
 
+#include <QTimer>
 #include <QUrl>
 
 #include "busobject.h"
+#include "fsutil.h"
 
 #include <KJob>
 
@@ -16,15 +18,29 @@ class GetCommand : public BusObject
 public:
     explicit GetCommand(const QUrl &url, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent = nullptr);
 
+    [[nodiscard]] bool isIdle() const override;
+
 public Q_SLOTS:
     void start();
     void kill();
 
 Q_SIGNALS:
     void data(const QByteArray &blob);
+    /** Stands in for @p length zero bytes the file doesn't store. Only sent for sparse files. */
+    void hole(qulonglong length);
     void result(int error, const QString &errorString);
     void mimeTypeFound(const QString &mimetype);
 
 private:
+    // Sparse files are read by us rather than KIO::get, which would send every hole as zeros.
+    bool startSparse();
+    void readSparse();
+    void finishSparse(int error, const QString &errorString);
+
     QUrl m_url;
+    UniqueFd m_fd;
+    off_t m_size = 0;
+    off_t m_offset = 0;
+    off_t m_extentEnd = 0;
+    QTimer m_readTimer;
 };
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "grepcommand.h"
+
+#include <QFile>
+
+#include <KIO/Global>
+
+GrepCommand::GrepCommand(const QUrl &url, const ContentQuery &query, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
+    : BusObject(remoteService, objectPath, parent)
+    , m_url(url)
+    , m_query(query)
+{
+}
+
+void GrepCommand::start()
+{
+    if (!isAuthorized()) {
+        sendErrorReply(QDBusError::AccessDenied);
+        return;
+    }
+
+    if (!m_url.isLocalFile()) {
+        sendSignal(&GrepCommand::result, int(KIO::ERR_UNSUPPORTED_ACTION), m_url.toString());
+        deleteLater();
+        return;
+    }
+
+    auto job = new ContentSearchJob(QFile::encodeName(m_url.toLocalFile()), m_query);
+    setParent(job);
+    connect(job, &ContentSearchJob::matches, this, [this](const QStringList &paths, const QList<qulonglong> &lineNumbers, const QStringList &lines) {
+        sendSignal(&GrepCommand::matches, paths, lineNumbers, lines);
+    });
+    connect(job, &KJob::result, this, [this, job](KJob *) {
+        sendSignal(&GrepCommand::result, job->error(), job->errorString());
+    });
+    job->start();
+}
+
+void GrepCommand::kill()
+{
+    doKill();
+}
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <QList>
+#include <QStringList>
+#include <QUrl>
+
+#include "busobject.h"
+#include "contentsearchjob.h"
+
+/** Searches file content below a directory and only sends back matching lines, see ContentSearchJob. */
+class GrepCommand : public BusObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kio.admin.GrepCommand")
+public:
+    explicit GrepCommand(const QUrl &url,
+                         const ContentQuery &query,
+                         const QString &remoteService,
+                         const QDBusObjectPath &objectPath,
+                         QObject *parent = nullptr);
+
+public Q_SLOTS:
+    void start();
+    void kill();
+
+Q_SIGNALS:
+    /** Matching lines, \a paths are local paths. Lines are cut off after 1024 bytes. */
+    void matches(const QStringList &paths, const QList<qulonglong> &lineNumbers, const QStringList &lines);
+    void result(int error, const QString &errorString);
+
+private:
+    const QUrl m_url;
+    const ContentQuery m_query;
+};
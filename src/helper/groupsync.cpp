@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "groupsync.h"
+
+#include <chrono>
+#include <utility>
+
+#include <QCoreApplication>
+
+#include "syncjob.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+// Long enough to catch the next put of a bulk deployment, short enough not to matter for a single file.
+constexpr auto groupWindow = 100ms;
+} // namespace
+
+GroupSync &GroupSync::instance()
+{
+    static auto instance = new GroupSync(QCoreApplication::instance());
+    return *instance;
+}
+
+GroupSync::GroupSync(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(groupWindow);
+    connect(&m_timer, &QTimer::timeout, this, &GroupSync::flush);
+}
+
+void GroupSync::sync(const QByteArray &path, QObject *context, Callback done)
+{
+    m_pending.push_back({path, context, std::move(done)});
+    if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+}
+
+void GroupSync::flush()
+{
+    QList<QByteArray> paths;
+    for (const auto &request : m_pending) {
+        paths << request.path;
+    }
+    auto job = new SyncJob(paths, SyncJob::Scope::Filesystems, this);
+    connect(job, &KJob::result, this, [job, requests = std::exchange(m_pending, {})] {
+        for (const auto &request : requests) {
+            if (request.context) {
+                request.done(job->error(), job->errorText());
+            }
+        }
+    });
+    job->start();
+}
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <QByteArray>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+/**
+ * Group commit for writes that want to be durable.
+ *
+ * Files handed in within a short window are flushed together with one syncfs per filesystem, so deploying many small
+ * files costs a single flush instead of an fsync per file and directory. The window starts with the first file, a
+ * steady stream of writes therefore can't postpone the flush indefinitely.
+ */
+class GroupSync : public QObject
+{
+    Q_OBJECT
+public:
+    static GroupSync &instance();
+
+    using Callback = std::function<void(int error, const QString &errorText)>;
+    /** Calls @p done with 0 or a KIO::Error once @p path is on stable storage, unless @p context is gone by then. */
+    void sync(const QByteArray &path, QObject *context, Callback done);
+
+private:
+    explicit GroupSync(QObject *parent);
+    void flush();
+
+    struct Request {
+        QByteArray path;
+        QPointer<QObject> context;
+        Callback done;
+    };
+    std::vector<Request> m_pending;
+    QTimer m_timer;
+};
@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "identitycache.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include <grp.h>
+#include <pwd.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <QHash>
+
+#include "workstealingpool.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr auto positiveTimeToLive = 5min;
+// Short, a missing user may well be a directory service hiccup.
+constexpr auto negativeTimeToLive = 30s;
+
+// getpwuid_r and friends want a caller supplied buffer. Grow it until the entry fits.
+template<typename Lookup>
+bool lookupWithBuffer(long sizeHint, Lookup lookup)
+{
+    std::vector<char> buffer(sizeHint > 0 ? sizeHint : 1024);
+    while (true) {
+        const int ret = lookup(buffer.data(), buffer.size());
+        if (ret != ERANGE) {
+            return ret == 0;
+        }
+        buffer.resize(buffer.size() * 2);
+    }
+}
+
+std::optional<QString> lookupUserName(uid_t uid)
+{
+    passwd entry{};
+    passwd *result = nullptr;
+    std::optional<QString> name;
+    lookupWithBuffer(sysconf(_SC_GETPW_R_SIZE_MAX), [&](char *buffer, size_t size) {
+        const int ret = getpwuid_r(uid, &entry, buffer, size, &result);
+        if (ret == 0 && result) {
+            name = QFile::decodeName(result->pw_name);
+        }
+        return ret;
+    });
+    return name;
+}
+
+std::optional<QString> lookupGroupName(gid_t gid)
+{
+    group entry{};
+    group *result = nullptr;
+    std::optional<QString> name;
+    lookupWithBuffer(sysconf(_SC_GETGR_R_SIZE_MAX), [&](char *buffer, size_t size) {
+        const int ret = getgrgid_r(gid, &entry, buffer, size, &result);
+        if (ret == 0 && result) {
+            name = QFile::decodeName(result->gr_name);
+        }
+        return ret;
+    });
+    return name;
+}
+
+std::optional<uid_t> lookupUserId(const QString &name)
+{
+    passwd entry{};
+    passwd *result = nullptr;
+    std::optional<uid_t> uid;
+    const auto encodedName = QFile::encodeName(name);
+    lookupWithBuffer(sysconf(_SC_GETPW_R_SIZE_MAX), [&](char *buffer, size_t size) {
+        const int ret = getpwnam_r(encodedName.constData(), &entry, buffer, size, &result);
+        if (ret == 0 && result) {
+            uid = result->pw_uid;
+        }
+        return ret;
+    });
+    return uid;
+}
+
+std::optional<gid_t> lookupGroupId(const QString &name)
+{
+    group entry{};
+    group *result = nullptr;
+    std::optional<gid_t> gid;
+    const auto encodedName = QFile::encodeName(name);
+    lookupWithBuffer(sysconf(_SC_GETGR_R_SIZE_MAX), [&](char *buffer, size_t size) {
+        const int ret = getgrnam_r(encodedName.constData(), &entry, buffer, size, &result);
+        if (ret == 0 && result) {
+            gid = result->gr_gid;
+        }
+        return ret;
+    });
+    return gid;
+}
+} // namespace
+
+class IdentityCache::Private
+{
+public:
+    template<typename Key, typename Value>
+    struct Table {
+        struct Entry {
+            std::optional<Value> value;
+            Clock::time_point expiry;
+            bool resolving = false;
+            bool resolved = false;
+        };
+        QHash<Key, Entry> entries;
+    };
+
+    template<typename Key, typename Value, typename Lookup>
+    std::optional<Value> get(Table<Key, Value> &table, const Key &key, Lookup lookup, bool allowStale = true)
+    {
+        std::unique_lock lock(mutex);
+        auto &entry = table.entries[key];
+        if (entry.resolved && Clock::now() < entry.expiry) {
+            ++statistics.hits;
+            return entry.value;
+        }
+        if (entry.resolved && !allowStale) {
+            // Asking NSS ourselves even if a refresh is underway, its answer may come too late for us to wait on.
+            ++statistics.misses;
+            lock.unlock();
+            return resolve(table, key, lookup);
+        }
+        if (entry.resolved) {
+            ++statistics.staleHits;
+            if (!entry.resolving) {
+                entry.resolving = true;
+                WorkStealingPool::instance().submit([this, &table, key, lookup] {
+                    resolve(table, key, lookup);
+                });
+            }
+            return entry.value;
+        }
+
+        ++statistics.misses;
+        if (entry.resolving) {
+            // Someone else is asking NSS already, no point in asking twice.
+            resolved.wait(lock, [&table, &key] {
+                return table.entries[key].resolved;
+            });
+            return table.entries[key].value;
+        }
+        entry.resolving = true;
+        lock.unlock();
+        return resolve(table, key, lookup);
+    }
+
+    template<typename Key, typename Value, typename Lookup>
+    std::optional<Value> resolve(Table<Key, Value> &table, const Key &key, Lookup lookup)
+    {
+        const auto start = Clock::now();
+        const auto value = lookup(key);
+        const auto end = Clock::now();
+
+        std::lock_guard lock(mutex);
+        auto &entry = table.entries[key];
+        entry.value = value;
+        entry.expiry = end + (value ? Clock::duration(positiveTimeToLive) : Clock::duration(negativeTimeToLive));
+        entry.resolving = false;
+        entry.resolved = true;
+
+        const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        ++statistics.lookups;
+        statistics.totalLookupTime += duration;
+        statistics.maxLookupTime = std::max(statistics.maxLookupTime, duration);
+        resolved.notify_all();
+        return value;
+    }
+
+    mutable std::mutex mutex;
+    std::condition_variable resolved;
+    Statistics statistics;
+    Table<uid_t, QString> userNames;
+    Table<gid_t, QString> groupNames;
+    Table<QString, uid_t> userIds;
+    Table<QString, gid_t> groupIds;
+};
+
+IdentityCache::IdentityCache()
+    : d(new Private)
+{
+}
+
+IdentityCache::~IdentityCache()
+{
+    delete d;
+}
+
+IdentityCache &IdentityCache::instance()
+{
+    // Leaked on purpose, background refreshes may still be running on the (equally leaked) pool at exit.
+    static auto cache = new IdentityCache;
+    return *cache;
+}
+
+QString IdentityCache::userName(uid_t uid)
+{
+    return d->get(d->userNames, uid, lookupUserName).value_or(QString::number(uid));
+}
+
+QString IdentityCache::groupName(gid_t gid)
+{
+    return d->get(d->groupNames, gid, lookupGroupName).value_or(QString::number(gid));
+}
+
+std::optional<uid_t> IdentityCache::userId(const QString &name, bool allowStale)
+{
+    return d->get(d->userIds, name, lookupUserId, allowStale);
+}
+
+std::optional<gid_t> IdentityCache::groupId(const QString &name, bool allowStale)
+{
+    return d->get(d->groupIds, name, lookupGroupId, allowStale);
+}
+
+IdentityCache::Statistics IdentityCache::statistics() const
+{
+    std::lock_guard lock(d->mutex);
+    return d->statistics;
+}
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+
+#include <QString>
+
+#include <sys/types.h>
+
+/**
+ * Shared, thread-safe cache for uid/gid <-> name resolution.
+ *
+ * Lookups may go through NSS to SSSD or LDAP and take a long time. Every answer, including "no such user", is
+ * remembered for a while so a listing only pays for each id once. Expired answers are still handed out while a
+ * refresh runs in the background on the WorkStealingPool; only the very first lookup of an id blocks, and only the
+ * threads asking for that very id. Lookups of ids that get written to disk can refuse expired answers.
+ */
+class IdentityCache
+{
+public:
+    struct Statistics {
+        quint64 hits = 0;
+        quint64 staleHits = 0; ///< Expired answers handed out while refreshing.
+        quint64 misses = 0;
+        quint64 lookups = 0; ///< Actual NSS lookups, including background refreshes.
+        std::chrono::microseconds totalLookupTime{0};
+        std::chrono::microseconds maxLookupTime{0};
+    };
+
+    static IdentityCache &instance();
+
+    /** @returns the login name of \a uid or the uid as string when there is no such user, like the file worker does. */
+    QString userName(uid_t uid);
+    /** @returns the name of \a gid or the gid as string when there is no such group. */
+    QString groupName(gid_t gid);
+    /**
+     * @returns the uid of the user called \a name. Pass false for \a allowStale when the id gets written to disk, an
+     * expired answer may belong to an account that was renamed or deleted since.
+     */
+    std::optional<uid_t> userId(const QString &name, bool allowStale = true);
+    /** @returns the gid of the group called \a name, see userId() for \a allowStale. */
+    std::optional<gid_t> groupId(const QString &name, bool allowStale = true);
+
+    [[nodiscard]] Statistics statistics() const;
+
+private:
+    IdentityCache();
+    ~IdentityCache();
+
+    class Private;
+    Private *const d;
+};
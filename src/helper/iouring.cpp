@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "iouring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <QtGlobal>
+
+#include "../kioadmin_debug.h"
+
+namespace
+{
+// A listing task's worth of entries, see LocalListJob.
+constexpr unsigned int ringEntries = 128;
+
+std::atomic<bool> s_unavailable = qEnvironmentVariableIsSet("KIO_ADMIN_DISABLE_IO_URING");
+std::atomic<quint64> s_rings = 0;
+std::atomic<quint64> s_enters = 0;
+std::atomic<quint64> s_operations = 0;
+
+template<typename T>
+T *at(void *ring, __u32 offset)
+{
+    return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+} // namespace
+
+IoUring::~IoUring()
+{
+    if (m_abandoned) {
+        return;
+    }
+    if (m_sqes) {
+        munmap(m_sqes, m_sqesSize);
+    }
+    if (m_cqRing && m_cqRing != m_sqRing) {
+        munmap(m_cqRing, m_cqRingSize);
+    }
+    if (m_sqRing) {
+        munmap(m_sqRing, m_sqRingSize);
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+IoUring *IoUring::forThisThread()
+{
+    thread_local std::unique_ptr<IoUring> ring;
+    thread_local bool attempted = false;
+    if (!ring && !attempted && !s_unavailable) {
+        attempted = true;
+        std::unique_ptr<IoUring> candidate(new IoUring);
+        if (candidate->setup(ringEntries)) {
+            ring = std::move(candidate);
+            ++s_rings;
+        } else {
+            // No point in every thread finding out for itself.
+            qCDebug(KIOADMIN_LOG) << "io_uring unavailable, using plain syscalls" << strerror(errno);
+            s_unavailable = true;
+        }
+    }
+    return ring && !ring->m_broken ? ring.get() : nullptr;
+}
+
+IoUring::Statistics IoUring::statistics()
+{
+    return {s_rings, s_enters, s_operations};
+}
+
+bool IoUring::setup(unsigned int entries)
+{
+    io_uring_params params{};
+    m_fd = int(syscall(__NR_io_uring_setup, entries, &params));
+    if (m_fd < 0) {
+        return false;
+    }
+
+    // IORING_OP_STATX came with 5.6, the same release as probing.
+    constexpr auto probeSize = sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op);
+    alignas(io_uring_probe) char probeBuffer[probeSize] = {};
+    auto probe = reinterpret_cast<io_uring_probe *>(probeBuffer);
+    if (syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0 || probe->last_op < IORING_OP_STATX
+        || !(probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED)) {
+        errno = EOPNOTSUPP;
+        return false;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(__u32);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+    }
+    m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED) {
+        m_sqRing = nullptr;
+        return false;
+    }
+    m_cqRing = singleMmap ? m_sqRing : mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+    if (m_cqRing == MAP_FAILED) {
+        m_cqRing = nullptr;
+        return false;
+    }
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    auto sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return false;
+    }
+    m_sqes = static_cast<io_uring_sqe *>(sqes);
+
+    m_entries = params.sq_entries;
+    m_sqTail = at<unsigned int>(m_sqRing, params.sq_off.tail);
+    m_sqMask = at<unsigned int>(m_sqRing, params.sq_off.ring_mask);
+    m_sqArray = at<unsigned int>(m_sqRing, params.sq_off.array);
+    m_cqHead = at<unsigned int>(m_cqRing, params.cq_off.head);
+    m_cqTail = at<unsigned int>(m_cqRing, params.cq_off.tail);
+    m_cqMask = at<unsigned int>(m_cqRing, params.cq_off.ring_mask);
+    m_cqes = at<io_uring_cqe>(m_cqRing, params.cq_off.cqes);
+    return true;
+}
+
+bool IoUring::statxAt(int dirFd,
+                      const std::vector<QByteArray> &names,
+                      size_t begin,
+                      size_t end,
+                      int flags,
+                      unsigned int mask,
+                      std::vector<struct statx> &buffers,
+                      std::vector<int> &results)
+{
+    if (m_broken) {
+        return false;
+    }
+    buffers.assign(end - begin, {});
+    results.assign(end - begin, -ECANCELED);
+
+    for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += m_entries) {
+        const auto count = unsigned(std::min<size_t>(end - chunkBegin, m_entries));
+
+        // We are the only producer, the tail is ours to read without ordering.
+        auto tail = *m_sqTail;
+        for (unsigned int i = 0; i < count; ++i) {
+            const auto index = tail & *m_sqMask;
+            auto sqe = &m_sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = dirFd;
+            sqe->addr = reinterpret_cast<__u64>(names.at(chunkBegin + i).constData());
+            sqe->len = mask;
+            sqe->statx_flags = flags;
+            sqe->off = reinterpret_cast<__u64>(&buffers.at(chunkBegin - begin + i));
+            sqe->user_data = chunkBegin - begin + i;
+            m_sqArray[index] = index;
+            ++tail;
+        }
+        __atomic_store_n(m_sqTail, tail, __ATOMIC_RELEASE);
+
+        unsigned int toSubmit = count;
+        unsigned int completed = 0;
+        while (completed < count) {
+            const auto submitted = syscall(__NR_io_uring_enter, m_fd, toSubmit, count - completed, IORING_ENTER_GETEVENTS, nullptr, 0);
+            ++s_enters;
+            if (submitted < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                qCWarning(KIOADMIN_LOG) << "io_uring_enter failed, using plain syscalls on this thread" << strerror(errno);
+                m_broken = true;
+                // What the kernel didn't take yet stays in the ring for good, we never enter with submissions again.
+                if (!drain(count - toSubmit - completed, results)) {
+                    // The kernel may still write into the buffers and read the names, they have to outlive us.
+                    qCWarning(KIOADMIN_LOG) << "Abandoning io_uring operations" << strerror(errno);
+                    m_abandoned = true;
+                    new std::vector<struct statx>(std::move(buffers));
+                    new std::vector<QByteArray>(names.cbegin() + qsizetype(begin), names.cbegin() + qsizetype(end));
+                }
+                return false;
+            }
+            if (submitted > 0) {
+                toSubmit -= std::min<unsigned int>(toSubmit, submitted);
+            }
+            completed += reapCompletions(results);
+        }
+        s_operations += count;
+    }
+    return true;
+}
+
+unsigned int IoUring::reapCompletions(std::vector<int> &results)
+{
+    unsigned int completed = 0;
+    auto head = *m_cqHead;
+    const auto cqTail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+    for (; head != cqTail; ++head) {
+        const auto &cqe = m_cqes[head & *m_cqMask];
+        results.at(cqe.user_data) = cqe.res;
+        ++completed;
+    }
+    __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+    return completed;
+}
+
+bool IoUring::drain(unsigned int inFlight, std::vector<int> &results)
+{
+    while (true) {
+        inFlight -= std::min(inFlight, reapCompletions(results));
+        if (inFlight == 0) {
+            return true;
+        }
+        const auto ret = syscall(__NR_io_uring_enter, m_fd, 0, inFlight, IORING_ENTER_GETEVENTS, nullptr, 0);
+        ++s_enters;
+        if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <vector>
+
+#include <QByteArray>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+/**
+ * A minimal io_uring, spoken to through the raw syscalls so we don't need liburing.
+ *
+ * Rings are per thread: every pool thread sets up its own on first use, so submitting needs no locking. Where io_uring
+ * can't be used (old kernels, io_uring_disabled, seccomp filters, KIO_ADMIN_DISABLE_IO_URING being set) forThisThread()
+ * returns nullptr and callers stick to plain syscalls on the WorkStealingPool.
+ */
+class IoUring
+{
+public:
+    struct Statistics {
+        quint64 rings = 0;
+        /** io_uring_enter calls. */
+        quint64 enters = 0;
+        /** Operations completed through them. */
+        quint64 operations = 0;
+    };
+
+    ~IoUring();
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    static IoUring *forThisThread();
+    static Statistics statistics();
+
+    /**
+     * statx()es names[begin, end) relative to \a dirFd, submitting as many at once as the ring holds.
+     * \a results receives 0 or the negated errno for every name, \a buffers the stat results.
+     * @returns false when the ring failed, the caller has to stat on its own then. The ring isn't used again.
+     */
+    bool statxAt(int dirFd,
+                 const std::vector<QByteArray> &names,
+                 size_t begin,
+                 size_t end,
+                 int flags,
+                 unsigned int mask,
+                 std::vector<struct statx> &buffers,
+                 std::vector<int> &results);
+
+private:
+    IoUring() = default;
+    bool setup(unsigned int entries);
+    /** Moves completions to \a results. @returns how many there were. */
+    unsigned int reapCompletions(std::vector<int> &results);
+    /** Waits for \a inFlight operations the kernel already took. @returns false if not even that works. */
+    bool drain(unsigned int inFlight, std::vector<int> &results);
+
+    int m_fd = -1;
+    void *m_sqRing = nullptr;
+    size_t m_sqRingSize = 0;
+    void *m_cqRing = nullptr;
+    size_t m_cqRingSize = 0;
+    struct io_uring_sqe *m_sqes = nullptr;
+    size_t m_sqesSize = 0;
+    unsigned int m_entries = 0;
+    bool m_broken = false;
+    // Operations we couldn't wait for, the kernel may still use the ring and their memory.
+    bool m_abandoned = false;
+
+    unsigned int *m_sqTail = nullptr;
+    unsigned int *m_sqMask = nullptr;
+    unsigned int *m_sqArray = nullptr;
+    unsigned int *m_cqHead = nullptr;
+    unsigned int *m_cqTail = nullptr;
+    unsigned int *m_cqMask = nullptr;
+    struct io_uring_cqe *m_cqes = nullptr;
+};
@@ -3,14 +3,46 @@
 
 #include "listdircommand.h"
 
+#include <utility>
+
+#include <sys/stat.h>
+
+#include <QFile>
+
 #include <KIO/ListJob>
 
-ListDirCommand::ListDirCommand(const QUrl &url, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
+#include "fsutil.h"
+#include "localentry.h"
+#include "locallistjob.h"
+#include "statcommand.h"
+
+ListDirCommand::ListDirCommand(const QUrl &url, KIO::StatDetails details, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
+    : BusObject(remoteService, objectPath, parent)
+    , m_url(url)
+    , m_details(details)
+    , m_sniffLater(details.testFlag(KIO::StatMimeType) && url.isLocalFile())
+{
+}
+
+ListDirCommand::ListDirCommand(const QUrl &url,
+                               KIO::StatDetails details,
+                               const LocalListJob::Range &range,
+                               const QString &remoteService,
+                               const QDBusObjectPath &objectPath,
+                               QObject *parent)
     : BusObject(remoteService, objectPath, parent)
     , m_url(url)
+    , m_details(details)
+    , m_range(range)
+    , m_sniffLater(details.testFlag(KIO::StatMimeType) && url.isLocalFile())
 {
 }
 
+void ListDirCommand::setValidator(qulonglong device, qulonglong inode, qlonglong modificationTime, qlonglong changeTime)
+{
+    m_knownState = LocalListJob::State{device, inode, modificationTime, changeTime};
+}
+
 void ListDirCommand::start()
 {
     if (!isAuthorized()) {
@@ -18,17 +50,102 @@ void ListDirCommand::start()
         return;
     }
 
+    // Determining the mimetype may mean reading file content, for every entry. Only do it when the client asked for it
+    // and even then not before the entries are out.
+    auto details = m_details;
+    details.setFlag(KIO::StatMimeType, m_details.testFlag(KIO::StatMimeType) && !m_sniffLater);
+
+    const auto sendEntries = [this, details](const KIO::UDSEntryList &list) {
+        if (details.testFlag(KIO::StatMimeType)) {
+            sendSignal(&ListDirCommand::entries, list);
+            return;
+        }
+        auto guessed = list;
+        for (auto &entry : guessed) {
+            applyMimeType(entry);
+        }
+        sendSignal(&ListDirCommand::entries, guessed);
+    };
+    const auto finish = [this](KJob *job) {
+        if (job->error() != KJob::NoError || m_sniffQueue.empty()) {
+            sendSignal(&ListDirCommand::result, job->error(), job->errorString());
+            return;
+        }
+        startSniffing();
+    };
+
+    const bool local = m_url.isLocalFile() && canCreateLocalUDSEntry(details);
+    if (m_range && !local) {
+        sendSignal(&ListDirCommand::result, int(KIO::ERR_UNSUPPORTED_ACTION), m_url.toString());
+        deleteLater();
+        return;
+    }
+
+    // Local directories are listed natively, which also gets owner and group names from the shared IdentityCache.
+    if (local) {
+        auto job = new LocalListJob(QFile::encodeName(m_url.toLocalFile()), details, m_range.value_or(LocalListJob::Range()));
+        if (m_knownState && !m_range) {
+            job->setKnownState(*m_knownState);
+        }
+        setParent(job);
+        connect(job, &LocalListJob::entries, this, sendEntries);
+        connect(job, &KJob::result, this, [this, job, finish] {
+            if (m_range && job->error() == KJob::NoError) {
+                sendSignal(&ListDirCommand::pageEnd, qlonglong(job->nextCursor()), job->atEnd());
+            }
+            if (job->error() == KJob::NoError && job->isNotModified()) {
+                sendSignal(&ListDirCommand::notModified);
+            } else if (const auto state = job->state(); !m_range && job->error() == KJob::NoError && state) {
+                sendSignal(&ListDirCommand::validator, qulonglong(state->device), qulonglong(state->inode), state->modificationTime, state->changeTime);
+            }
+            finish(job);
+        });
+        job->start();
+        return;
+    }
+
     auto job = KIO::listDir(m_url);
-    // Since we aren't file: proper we need to ensure that a mimetype is available. Otherwise KIO has a hard time guessing
-    // what is going on and can end up without a mimetype.
-    job->addMetaData(QStringLiteral("statDetails"), QString::number(KIO::StatDefaultDetails | KIO::StatMimeType));
+    job->addMetaData(QStringLiteral("statDetails"), QString::number(details));
+    setParent(job);
+    connect(job, &KIO::ListJob::entries, this, [sendEntries](KIO::Job *, const KIO::UDSEntryList &list) {
+        sendEntries(list);
+    });
+    connect(job, &KIO::ListJob::result, this, finish);
+}
+
+void ListDirCommand::applyMimeType(KIO::UDSEntry &entry)
+{
+    if (!m_sniffLater || (entry.numberValue(KIO::UDSEntry::UDS_FILE_TYPE) & S_IFMT) != S_IFREG) {
+        StatCommand::guessMimeType(entry);
+        return;
+    }
+
+    const auto name = entry.stringValue(KIO::UDSEntry::UDS_NAME);
+    const auto path = joinPath(QFile::encodeName(m_url.toLocalFile()), QFile::encodeName(name));
+    const auto size = entry.numberValue(KIO::UDSEntry::UDS_SIZE);
+    const auto modificationTime = entry.numberValue(KIO::UDSEntry::UDS_MODIFICATION_TIME);
+    if (const auto mimeType = MimeTypeSniffJob::cachedMimeType(path, size, modificationTime)) {
+        entry.fastInsert(KIO::UDSEntry::UDS_MIME_TYPE, mimeType.value());
+        return;
+    }
+
+    StatCommand::guessMimeType(entry);
+    m_sniffQueue.push_back({name, path, size, modificationTime, entry.stringValue(KIO::UDSEntry::UDS_GUESSED_MIME_TYPE)});
+}
+
+void ListDirCommand::startSniffing()
+{
+    auto job = new MimeTypeSniffJob(std::exchange(m_sniffQueue, {}));
+    // Moves us away from the finished listing job, which is about to delete itself.
     setParent(job);
-    connect(job, &KIO::ListJob::entries, this, [this](KIO::Job *, const KIO::UDSEntryList &list) {
-        sendSignal(&ListDirCommand::entries, list);
+    connect(job, &MimeTypeSniffJob::mimeTypes, this, [this](const QStringList &names, const QStringList &mimeTypes) {
+        sendSignal(&ListDirCommand::mimeTypes, names, mimeTypes);
     });
-    connect(job, &KIO::ListJob::result, this, [this](KJob *job) {
-        sendSignal(&ListDirCommand::result, job->error(), job->errorString());
+    // Not being able to sniff a file doesn't make the listing any less successful.
+    connect(job, &KJob::result, this, [this] {
+        sendSignal(&ListDirCommand::result, int(KJob::NoError), QString());
     });
+    job->start();
 }
 
 void ListDirCommand::kill()
@@ -3,27 +3,67 @@
 
 #pragma once
 
+#include <optional>
+#include <vector>
+
+#include <QStringList>
 #include <QUrl>
 
+#include <KIO/Global>
 #include <KIO/UDSEntry>
 
 #include "busobject.h"
+#include "locallistjob.h"
+#include "mimetypesniffjob.h"
 
 class ListDirCommand : public BusObject
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.kde.kio.admin.ListDirCommand")
 public:
-    explicit ListDirCommand(const QUrl &url, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent = nullptr);
+    explicit ListDirCommand(const QUrl &url,
+                            KIO::StatDetails details,
+                            const QString &remoteService,
+                            const QDBusObjectPath &objectPath,
+                            QObject *parent = nullptr);
+    /** Lists one page of a local directory, see LocalListJob::Range. */
+    explicit ListDirCommand(const QUrl &url,
+                            KIO::StatDetails details,
+                            const LocalListJob::Range &range,
+                            const QString &remoteService,
+                            const QDBusObjectPath &objectPath,
+                            QObject *parent = nullptr);
 
 public Q_SLOTS:
+    /**
+     * Passes the validator() of an earlier listing. If the directory is unchanged, notModified() is sent instead of
+     * entries(). Only complete local listings can be validated. Call before start().
+     */
+    void setValidator(qulonglong device, qulonglong inode, qlonglong modificationTime, qlonglong changeTime);
     void start();
     void kill();
 
 Q_SIGNALS:
     void entries(const KIO::UDSEntryList &list);
+    /** Follow-up to entries(), the content of these files says something else than their names suggested. */
+    void mimeTypes(const QStringList &names, const QStringList &mimeTypes);
+    /** Sent before result() of a ranged listing. \a cursor is where the next page starts. */
+    void pageEnd(qlonglong cursor, bool atEnd);
+    /** Sent before result() of a complete listing that can be validated later on, see setValidator(). */
+    void validator(qulonglong device, qulonglong inode, qlonglong modificationTime, qlonglong changeTime);
+    /** Sent before result() when the directory still is as it was when the validator was made. */
+    void notModified();
     void result(int error, const QString &errorString);
 
 private:
+    void applyMimeType(KIO::UDSEntry &entry);
+    void startSniffing();
+
     const QUrl m_url;
+    const KIO::StatDetails m_details;
+    const std::optional<LocalListJob::Range> m_range;
+    std::optional<LocalListJob::State> m_knownState;
+    // Content sniffing of local files happens after the listing, see MimeTypeSniffJob.
+    const bool m_sniffLater;
+    std::vector<MimeTypeSniffJob::File> m_sniffQueue;
 };
@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "localentry.h"
+
+#include <climits>
+#include <optional>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <QMimeDatabase>
+#include <QtEndian>
+
+#include "../dbustypes.h"
+#include "identitycache.h"
+
+namespace
+{
+bool statxAt(int dirFd, const QByteArray &name, int flags, struct statx &buffer)
+{
+    return statx(dirFd, name.constData(), flags | AT_NO_AUTOMOUNT, localEntryStatxMask, &buffer) == 0;
+}
+
+// The kernel's format of the system.posix_acl_access and system.posix_acl_default extended attributes, see
+// linux/posix_acl_xattr.h. All fields are little endian.
+constexpr quint32 aclAttributeVersion = 2;
+constexpr qsizetype aclHeaderSize = 4;
+constexpr qsizetype aclEntrySize = 8;
+enum AclTag : quint16 {
+    AclUserObject = 0x01,
+    AclUser = 0x02,
+    AclGroupObject = 0x04,
+    AclGroup = 0x08,
+    AclMask = 0x10,
+    AclOther = 0x20,
+};
+
+/**
+ * Reads the ACL in the extended attribute \a name of \a path, following symlinks like acl_get_file() does.
+ * @returns the ACL in the long text form of acl_to_text(), nothing when there is none or \a minimal is false and it
+ * merely mirrors the mode bits.
+ */
+std::optional<QString> readAcl(const QByteArray &path, const char *name, bool minimal)
+{
+    // Most files have no ACL, which costs just this one call.
+    auto size = getxattr(path.constData(), name, nullptr, 0);
+    if (size < aclHeaderSize) {
+        return std::nullopt;
+    }
+    QByteArray attribute(size, Qt::Uninitialized);
+    size = getxattr(path.constData(), name, attribute.data(), attribute.size());
+    if (size < aclHeaderSize || qFromLittleEndian<quint32>(attribute.constData()) != aclAttributeVersion) {
+        return std::nullopt;
+    }
+
+    auto &identities = IdentityCache::instance();
+    QString text;
+    bool extended = false;
+    for (qsizetype offset = aclHeaderSize; offset + aclEntrySize <= size; offset += aclEntrySize) {
+        const auto tag = qFromLittleEndian<quint16>(attribute.constData() + offset);
+        const auto permissions = qFromLittleEndian<quint16>(attribute.constData() + offset + 2);
+        const auto id = qFromLittleEndian<quint32>(attribute.constData() + offset + 4);
+        switch (tag) {
+        case AclUserObject:
+            text += QLatin1String("user::");
+            break;
+        case AclUser:
+            text += QLatin1String("user:") + identities.userName(id) + QLatin1Char(':');
+            extended = true;
+            break;
+        case AclGroupObject:
+            text += QLatin1String("group::");
+            break;
+        case AclGroup:
+            text += QLatin1String("group:") + identities.groupName(id) + QLatin1Char(':');
+            extended = true;
+            break;
+        case AclMask:
+            text += QLatin1String("mask::");
+            extended = true;
+            break;
+        case AclOther:
+            text += QLatin1String("other::");
+            break;
+        default:
+            continue;
+        }
+        text += QLatin1Char(permissions & 4 ? 'r' : '-');
+        text += QLatin1Char(permissions & 2 ? 'w' : '-');
+        text += QLatin1Char(permissions & 1 ? 'x' : '-');
+        text += QLatin1Char('\n');
+    }
+    if (text.isEmpty() || (!minimal && !extended)) {
+        return std::nullopt;
+    }
+    return text;
+}
+
+// Same atoms as the file worker's appendACLAtoms(), without going through libacl.
+void appendAcls(const QByteArray &path, mode_t type, KIO::UDSEntry &entry)
+{
+    const auto acl = readAcl(path, "system.posix_acl_access", false);
+    const auto defaultAcl = S_ISDIR(type) ? readAcl(path, "system.posix_acl_default", true) : std::nullopt;
+    if (acl || defaultAcl) {
+        entry.fastInsert(KIO::UDSEntry::UDS_EXTENDED_ACL, 1);
+    }
+    if (acl) {
+        entry.fastInsert(KIO::UDSEntry::UDS_ACL_STRING, acl.value());
+    }
+    if (defaultAcl) {
+        entry.fastInsert(KIO::UDSEntry::UDS_DEFAULT_ACL_STRING, defaultAcl.value());
+    }
+}
+} // namespace
+
+bool canCreateLocalUDSEntry(KIO::StatDetails details)
+{
+    return !details.testFlag(KIO::StatRecursiveSize);
+}
+
+bool createLocalUDSEntry(int dirFd, const QByteArray &name, const QString &displayName, const QByteArray &path, KIO::StatDetails details, KIO::UDSEntry &entry)
+{
+    struct statx buffer {
+    };
+    if (!statxAt(dirFd, name, AT_SYMLINK_NOFOLLOW, buffer)) {
+        return false;
+    }
+    createLocalUDSEntry(dirFd, name, displayName, path, details, buffer, entry);
+    return true;
+}
+
+void createLocalUDSEntry(int dirFd,
+                         const QByteArray &name,
+                         const QString &displayName,
+                         const QByteArray &path,
+                         KIO::StatDetails details,
+                         struct statx buffer,
+                         KIO::UDSEntry &entry)
+{
+    entry.reserve(12);
+    if (details & KIO::StatBasic) {
+        entry.fastInsert(KIO::UDSEntry::UDS_NAME, displayName);
+    }
+
+    bool isBrokenLink = false;
+    if (S_ISLNK(buffer.stx_mode)) {
+        if (details & (KIO::StatBasic | KIO::StatResolveSymlink)) {
+            // readlink rather than QFileInfo::symLinkTarget, the latter makes relative targets absolute.
+            QByteArray target(PATH_MAX, Qt::Uninitialized);
+            const auto length = readlinkat(dirFd, name.constData(), target.data(), target.size());
+            if (length >= 0) {
+                target.truncate(length);
+                entry.fastInsert(KIO::UDSEntry::UDS_LINK_DEST, QFile::decodeName(target));
+            }
+        }
+        if (details & KIO::StatResolveSymlink) {
+            struct statx targetBuffer {
+            };
+            if (statxAt(dirFd, name, 0, targetBuffer)) {
+                buffer = targetBuffer;
+            } else {
+                isBrokenLink = true;
+            }
+        }
+    }
+
+    if (details & KIO::StatBasic) {
+        if (isBrokenLink) {
+            // A link pointing to nowhere, same magic type as the file worker uses.
+            entry.fastInsert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFMT - 1);
+            entry.fastInsert(KIO::UDSEntry::UDS_ACCESS, S_IRWXU | S_IRWXG | S_IRWXO);
+            entry.fastInsert(KIO::UDSEntry::UDS_SIZE, 0LL);
+        } else {
+            entry.fastInsert(KIO::UDSEntry::UDS_FILE_TYPE, buffer.stx_mode & S_IFMT);
+            entry.fastInsert(KIO::UDSEntry::UDS_ACCESS, buffer.stx_mode & 07777);
+            entry.fastInsert(KIO::UDSEntry::UDS_SIZE, buffer.stx_size);
+        }
+    }
+
+    if (details & KIO::StatUser) {
+        auto &identities = IdentityCache::instance();
+        entry.fastInsert(KIO::UDSEntry::UDS_USER, identities.userName(buffer.stx_uid));
+        entry.fastInsert(KIO::UDSEntry::UDS_GROUP, identities.groupName(buffer.stx_gid));
+    }
+
+    if (details & KIO::StatTime) {
+        entry.fastInsert(KIO::UDSEntry::UDS_MODIFICATION_TIME, buffer.stx_mtime.tv_sec);
+        entry.fastInsert(KIO::UDSEntry::UDS_ACCESS_TIME, buffer.stx_atime.tv_sec);
+        if (buffer.stx_mask & STATX_BTIME) {
+            entry.fastInsert(KIO::UDSEntry::UDS_CREATION_TIME, buffer.stx_btime.tv_sec);
+        }
+    }
+
+    if (details & KIO::StatInode) {
+        entry.fastInsert(KIO::UDSEntry::UDS_DEVICE_ID, makedev(buffer.stx_dev_major, buffer.stx_dev_minor));
+        entry.fastInsert(KIO::UDSEntry::UDS_INODE, buffer.stx_ino);
+    }
+
+    if (details & KIO::StatAcl) {
+        appendAcls(path, buffer.stx_mode, entry);
+    }
+
+    if (details & KIO::StatMimeType) {
+        static const QMimeDatabase database;
+        entry.fastInsert(KIO::UDSEntry::UDS_MIME_TYPE, database.mimeTypeForFile(QFile::decodeName(path)).name());
+    }
+}
+
+void createIncompleteLocalUDSEntry(const QString &displayName, mode_t type, KIO::StatDetails details, KIO::UDSEntry &entry)
+{
+    entry.reserve(4);
+    if (details & KIO::StatBasic) {
+        entry.fastInsert(KIO::UDSEntry::UDS_NAME, displayName);
+        entry.fastInsert(KIO::UDSEntry::UDS_FILE_TYPE, type & S_IFMT);
+    }
+    if (details & KIO::StatMimeType) {
+        // Determining it from the path would stat all over again.
+        entry.fastInsert(KIO::UDSEntry::UDS_MIME_TYPE, S_ISDIR(type) ? QStringLiteral("inode/directory") : QStringLiteral("application/octet-stream"));
+    }
+    entry.fastInsert(UDS_ADMIN_INCOMPLETE, 1);
+}
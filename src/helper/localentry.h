@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <KIO/Global>
+#include <KIO/UDSEntry>
+
+/** What createLocalUDSEntry() statx()es entries with, for callers that batch the statx themselves. */
+constexpr int localEntryStatxFlags = AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT;
+constexpr unsigned int localEntryStatxMask = STATX_BASIC_STATS | STATX_BTIME;
+
+/** @returns whether createLocalUDSEntry() can provide all of \a details. Recursive sizes are left to the file worker. */
+bool canCreateLocalUDSEntry(KIO::StatDetails details);
+
+/**
+ * Stats \a name relative to \a dirFd and fills \a entry the same way the file worker would. Owner and group names
+ * come from the IdentityCache. \a path is the full path of the entry, it is used for mimetype determination.
+ *
+ * @returns false and leaves errno set when \a name cannot be stat'ed.
+ */
+bool createLocalUDSEntry(int dirFd, const QByteArray &name, const QString &displayName, const QByteArray &path, KIO::StatDetails details, KIO::UDSEntry &entry);
+
+/** Like the above but with \a buffer stat'ed by the caller, using localEntryStatxFlags and localEntryStatxMask. */
+void createLocalUDSEntry(int dirFd,
+                         const QByteArray &name,
+                         const QString &displayName,
+                         const QByteArray &path,
+                         KIO::StatDetails details,
+                         struct statx buffer,
+                         KIO::UDSEntry &entry);
+
+/** Fills \a entry with what is known without stat'ing, for entries that didn't answer in time. */
+void createIncompleteLocalUDSEntry(const QString &displayName, mode_t type, KIO::StatDetails details, KIO::UDSEntry &entry);
@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "locallistjob.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <utility>
+
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/sysmacros.h>
+#include <time.h>
+
+#include <QFile>
+
+#include "fsutil.h"
+#include "iouring.h"
+#include "localentry.h"
+#include "mounttable.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+constexpr auto entriesPerTask = 128;
+// A mount point that takes longer than this is listed with what getdents told us, the rest of the listing goes on.
+constexpr auto suspectStatTimeout = 2s;
+// Filesystems take their timestamps from a coarse clock. Changes within this long after the one the directory's times
+// record may not show in them.
+constexpr auto timestampGranularity = 1s;
+
+qint64 toNanoseconds(const statx_timestamp &time)
+{
+    return qint64(time.tv_sec) * 1'000'000'000 + time.tv_nsec;
+}
+} // namespace
+
+class LocalLister : public PoolOperation
+{
+public:
+    LocalLister(const QByteArray &path, KIO::StatDetails details, const LocalListJob::Range &range)
+        : m_path(path)
+        , m_details(details)
+        , m_range(range)
+    {
+        const auto patterns = range.nameFilter.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+        for (const auto &pattern : patterns) {
+            m_patterns.push_back(QFile::encodeName(pattern));
+        }
+    }
+
+    // Only read after the operation finished.
+    qint64 nextCursor = 0;
+    bool atEnd = false;
+    bool notModified = false;
+    std::optional<LocalListJob::State> state;
+    // Only written before the operation starts.
+    std::optional<LocalListJob::State> knownState;
+
+    KIO::UDSEntryList takeEntries()
+    {
+        std::lock_guard lock(m_mutex);
+        return std::exchange(m_entries, {});
+    }
+
+protected:
+    void run() override
+    {
+        m_fd = std::make_shared<UniqueFd>(open(m_path.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        const auto limit = m_range.limit < 0 ? std::numeric_limits<size_t>::max() : size_t(m_range.limit);
+        std::function<bool(const char *)> filter;
+        if (!m_patterns.empty()) {
+            filter = [this](const char *name) {
+                return std::any_of(m_patterns.cbegin(), m_patterns.cend(), [name](const QByteArray &pattern) {
+                    return fnmatch(pattern.constData(), name, 0) == 0;
+                });
+            };
+        }
+        // Only complete listings can stand in for later ones.
+        if (m_fd->isValid() && m_range.cursor == 0 && m_range.limit < 0 && m_patterns.empty()) {
+            readState();
+            if (notModified) {
+                return;
+            }
+        }
+        DirectoryPage page;
+        if (!m_fd->isValid() || !readDirectoryPage(m_fd->get(), m_range.cursor, limit, filter, page)) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_ENTER_DIRECTORY), m_path);
+            return;
+        }
+        nextCursor = page.nextCursor;
+        atEnd = page.atEnd;
+        m_suspects = MountTable::instance().suspectsIn(m_path);
+
+        auto names = std::make_shared<std::vector<QByteArray>>();
+        names->reserve(page.entries.size() + 2);
+        if (m_range.cursor == 0) {
+            names->push_back(QByteArrayLiteral("."));
+            names->push_back(QByteArrayLiteral(".."));
+        }
+        for (auto &entry : page.entries) {
+            names->push_back(std::move(entry.name));
+        }
+
+        for (size_t begin = 0; begin < names->size(); begin += entriesPerTask) {
+            const auto end = std::min(begin + entriesPerTask, names->size());
+            schedule([self = sharedSelf<LocalLister>(), names, begin, end] {
+                self->stat(*names, begin, end);
+            });
+        }
+    }
+
+private:
+    void readState()
+    {
+        struct statx buffer {
+        };
+        if (statx(m_fd->get(), "", AT_EMPTY_PATH, STATX_INO | STATX_MTIME | STATX_CTIME, &buffer) != 0) {
+            return;
+        }
+        const LocalListJob::State current{makedev(buffer.stx_dev_major, buffer.stx_dev_minor),
+                                          buffer.stx_ino,
+                                          toNanoseconds(buffer.stx_mtime),
+                                          toNanoseconds(buffer.stx_ctime)};
+        if (knownState == current) {
+            notModified = true;
+            return;
+        }
+        // The change time can't be set from userspace, unlike the modification time.
+        timespec now{};
+        clock_gettime(CLOCK_REALTIME, &now);
+        const auto sinceChange = std::chrono::nanoseconds(qint64(now.tv_sec) * 1'000'000'000 + now.tv_nsec - current.changeTime);
+        if (sinceChange >= timestampGranularity) {
+            state = current;
+        }
+    }
+
+    void stat(const std::vector<QByteArray> &names, size_t begin, size_t end)
+    {
+        KIO::UDSEntryList list;
+        list.reserve(end - begin);
+        const auto hasSuspects = !m_suspects.isEmpty() && std::any_of(names.cbegin() + begin, names.cbegin() + end, [this](const QByteArray &name) {
+            return m_suspects.contains(name);
+        });
+        // With io_uring the whole task's worth of statx goes to the kernel in one go. A hanging one would hold up all.
+        auto ring = hasSuspects ? nullptr : IoUring::forThisThread();
+        std::vector<struct statx> buffers;
+        std::vector<int> results;
+        if (ring && !ring->statxAt(m_fd->get(), names, begin, end, localEntryStatxFlags, localEntryStatxMask, buffers, results)) {
+            ring = nullptr;
+        }
+        for (auto i = begin; i < end && !isCanceled(); ++i) {
+            const auto &name = names.at(i);
+            KIO::UDSEntry entry;
+            // Entries vanishing while we list are simply not listed.
+            if (hasSuspects && m_suspects.contains(name)) {
+                if (statSuspect(name, entry)) {
+                    list.append(std::move(entry));
+                }
+            } else if (ring) {
+                if (results.at(i - begin) == 0) {
+                    createLocalUDSEntry(m_fd->get(), name, QFile::decodeName(name), joinPath(m_path, name), m_details, buffers.at(i - begin), entry);
+                    list.append(std::move(entry));
+                }
+            } else if (createLocalUDSEntry(m_fd->get(), name, QFile::decodeName(name), joinPath(m_path, name), m_details, entry)) {
+                list.append(std::move(entry));
+            }
+        }
+
+        std::lock_guard lock(m_mutex);
+        m_entries.append(list);
+    }
+
+    bool statSuspect(const QByteArray &name, KIO::UDSEntry &entry)
+    {
+        const auto path = joinPath(m_path, name);
+        struct statx buffer {
+        };
+        switch (MountTable::instance().statx(path, localEntryStatxFlags, localEntryStatxMask, buffer, suspectStatTimeout)) {
+        case MountTable::StatResult::Ok:
+            // Reading the ACL could hang just like the stat, the file worker would not get to list the directory either.
+            createLocalUDSEntry(m_fd->get(), name, QFile::decodeName(name), path, KIO::StatDetails(m_details).setFlag(KIO::StatAcl, false), buffer, entry);
+            return true;
+        case MountTable::StatResult::TimedOut:
+            // Mount points are directories, that much we know.
+            createIncompleteLocalUDSEntry(QFile::decodeName(name), S_IFDIR, m_details, entry);
+            return true;
+        case MountTable::StatResult::Failed:
+            break;
+        }
+        return false;
+    }
+
+    const QByteArray m_path;
+    const KIO::StatDetails m_details;
+    const LocalListJob::Range m_range;
+    std::vector<QByteArray> m_patterns;
+    std::shared_ptr<UniqueFd> m_fd;
+    // Mount points in the directory that may not answer, only written before the stat tasks get scheduled.
+    QSet<QByteArray> m_suspects;
+    KIO::UDSEntryList m_entries;
+};
+
+LocalListJob::LocalListJob(const QByteArray &path, KIO::StatDetails details, QObject *parent)
+    : LocalListJob(path, details, Range(), parent)
+{
+}
+
+LocalListJob::LocalListJob(const QByteArray &path, KIO::StatDetails details, const Range &range, QObject *parent)
+    : LocalListJob(std::make_shared<LocalLister>(path, details, range), parent)
+{
+}
+
+LocalListJob::LocalListJob(const std::shared_ptr<LocalLister> &lister, QObject *parent)
+    : PoolJob(lister, parent)
+    , m_lister(lister)
+{
+    setPriority(WorkStealingPool::Priority::Interactive);
+}
+
+LocalListJob::~LocalListJob() = default;
+
+qint64 LocalListJob::nextCursor() const
+{
+    return m_lister->nextCursor;
+}
+
+bool LocalListJob::atEnd() const
+{
+    return m_lister->atEnd;
+}
+
+void LocalListJob::setKnownState(const State &state)
+{
+    m_lister->knownState = state;
+}
+
+bool LocalListJob::isNotModified() const
+{
+    return m_lister->notModified;
+}
+
+std::optional<LocalListJob::State> LocalListJob::state() const
+{
+    return m_lister->state;
+}
+
+void LocalListJob::updateProgress()
+{
+    const auto list = m_lister->takeEntries();
+    if (!list.isEmpty()) {
+        Q_EMIT entries(list);
+    }
+}
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include <QString>
+
+#include <KIO/Global>
+#include <KIO/UDSEntry>
+
+#include "pooljob.h"
+
+class LocalLister;
+
+/**
+ * Lists a local directory without going through the file worker.
+ *
+ * The directory is read with getdents, the entries are stat'ed in chunks on the WorkStealingPool and delivered in
+ * batches through entries(). Like the file worker the listing includes "." and "..".
+ *
+ * Huge directories can be listed in pages by passing a Range. Each page continues at the cursor the previous one ended
+ * at, only "." and ".." are listed on the first page.
+ *
+ * A client that kept an earlier listing can pass the State it got along with it. If the directory still is in that
+ * state nothing gets listed and isNotModified() is true.
+ */
+class LocalListJob : public PoolJob
+{
+    Q_OBJECT
+public:
+    struct Range {
+        /** Opaque position within the directory as returned by nextCursor(), 0 is the start. */
+        qint64 cursor = 0;
+        /** Maximum number of entries, not counting "." and "..". Negative for no limit. */
+        qsizetype limit = -1;
+        /** Whitespace separated shell globs, an entry is listed when any of them matches. Empty for no filter. */
+        QString nameFilter;
+    };
+
+    /**
+     * Identity and change markers of a directory. Adding, removing or renaming an entry changes the times, changes of
+     * the entries themselves don't.
+     */
+    struct State {
+        quint64 device = 0;
+        quint64 inode = 0;
+        /** Nanoseconds since the epoch. */
+        qint64 modificationTime = 0;
+        qint64 changeTime = 0;
+
+        bool operator==(const State &other) const = default;
+    };
+
+    LocalListJob(const QByteArray &path, KIO::StatDetails details, QObject *parent = nullptr);
+    LocalListJob(const QByteArray &path, KIO::StatDetails details, const Range &range, QObject *parent = nullptr);
+    ~LocalListJob() override;
+
+    /** @returns where the next page starts, valid once the job finished without error. */
+    [[nodiscard]] qint64 nextCursor() const;
+    /** @returns whether the listing reached the end of the directory, valid once the job finished without error. */
+    [[nodiscard]] bool atEnd() const;
+
+    /** Skips the listing if the directory still is in \a state. Call before start(). */
+    void setKnownState(const State &state);
+    /** @returns whether the directory still was in the known state, valid once the job finished without error. */
+    [[nodiscard]] bool isNotModified() const;
+    /**
+     * @returns the state the directory was in when the listing began, valid once the job finished without error.
+     * Empty when the directory changed too recently for its times to tell later changes apart.
+     */
+    [[nodiscard]] std::optional<State> state() const;
+
+Q_SIGNALS:
+    void entries(const KIO::UDSEntryList &list);
+
+protected:
+    void updateProgress() override;
+
+private:
+    LocalListJob(const std::shared_ptr<LocalLister> &lister, QObject *parent);
+
+    const std::shared_ptr<LocalLister> m_lister;
+};
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "localstatjob.h"
+
+#include <fcntl.h>
+
+#include <QFile>
+
+#include "fsutil.h"
+#include "localentry.h"
+
+class LocalStater : public PoolOperation
+{
+public:
+    LocalStater(const QByteArray &path, KIO::StatDetails details)
+        : m_path(path)
+        , m_details(details)
+    {
+    }
+
+    // Only read after the operation finished.
+    KIO::UDSEntry entry;
+
+protected:
+    void run() override
+    {
+        const auto slash = m_path.lastIndexOf('/');
+        const auto name = QFile::decodeName(slash < 0 ? m_path : m_path.mid(slash + 1));
+        if (!createLocalUDSEntry(AT_FDCWD, m_path, name, m_path, m_details, entry)) {
+            fail(errnoToKIOError(errno, KIO::ERR_DOES_NOT_EXIST), m_path);
+        }
+    }
+
+private:
+    const QByteArray m_path;
+    const KIO::StatDetails m_details;
+};
+
+LocalStatJob::LocalStatJob(const QByteArray &path, KIO::StatDetails details, QObject *parent)
+    : LocalStatJob(std::make_shared<LocalStater>(path, details), parent)
+{
+}
+
+LocalStatJob::LocalStatJob(const std::shared_ptr<LocalStater> &stater, QObject *parent)
+    : PoolJob(stater, parent)
+    , m_stater(stater)
+{
+    setPriority(WorkStealingPool::Priority::Interactive);
+}
+
+LocalStatJob::~LocalStatJob() = default;
+
+KIO::UDSEntry LocalStatJob::statResult() const
+{
+    return m_stater->entry;
+}
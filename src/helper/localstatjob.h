@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <memory>
+
+#include <KIO/Global>
+#include <KIO/UDSEntry>
+
+#include "pooljob.h"
+
+class LocalStater;
+
+/** Stats a local path without going through the file worker. Runs on the WorkStealingPool, NSS lookups may block. */
+class LocalStatJob : public PoolJob
+{
+    Q_OBJECT
+public:
+    LocalStatJob(const QByteArray &path, KIO::StatDetails details, QObject *parent = nullptr);
+    ~LocalStatJob() override;
+
+    /** @returns the entry, valid once the job finished without error. */
+    [[nodiscard]] KIO::UDSEntry statResult() const;
+
+private:
+    LocalStatJob(const std::shared_ptr<LocalStater> &stater, QObject *parent);
+
+    const std::shared_ptr<LocalStater> m_stater;
+};
@@ -1,29 +1,55 @@
 // SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 // SPDX-FileCopyrightText: 2022 Harald Sitter <sitter@kde.org>
 
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <utility>
+
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QCommandLineParser>
 #include <QCoreApplication>
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
 #include <QDBusContext>
 #include <QDBusMetaType>
+#include <QDBusServiceWatcher>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QTimer>
 
+#include <KIO/Global>
 #include <KIO/JobUiDelegateExtension>
 #include <KIO/JobUiDelegateFactory>
 
 #include "../dbustypes.h"
 #include "auth.h"
+#include "batchcommand.h"
 #include "busobject.h"
+#include "checksumcommand.h"
 #include "chmodcommand.h"
 #include "chowncommand.h"
+#include "commandtable.h"
 #include "copycommand.h"
 #include "delcommand.h"
 #include "file.h"
+#include "findcommand.h"
 #include "getcommand.h"
+#include "grepcommand.h"
+#include "identitycache.h"
+#include "iouring.h"
 #include "listdircommand.h"
 #include "mkdircommand.h"
 #include "putcommand.h"
 #include "renamecommand.h"
+#include "sizecommand.h"
 #include "statcommand.h"
+#include "watchcommand.h"
+#include "workstealingpool.h"
 
 static QUrl stringToUrl(const QString &stringUrl)
 {
@@ -34,44 +60,163 @@ static QUrl stringToUrl(const QString &stringUrl)
     return url;
 }
 
+static QList<QUrl> stringsToUrls(const QStringList &stringUrls)
+{
+    QList<QUrl> urls;
+    urls.reserve(stringUrls.size());
+    for (const auto &stringUrl : stringUrls) {
+        urls.append(stringToUrl(stringUrl));
+    }
+    return urls;
+}
+
+// Native tree operations hold a directory fd for every directory in flight. Allow as many as we are permitted to.
+static void raiseFileDescriptorLimit()
+{
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+            qWarning() << "Failed to raise the file descriptor limit";
+        }
+    }
+}
+
+using namespace std::chrono_literals;
+
+// Long enough that browsing around doesn't start a new helper (and a new authorization) every time.
+static constexpr auto defaultIdleTimeout = 5min;
+// Calls already on their way when we give up the name still get served, they had this long to arrive.
+static constexpr auto exitGracePeriod = 1s;
+
+static struct {
+    // From exec() to serving, i.e. including the dynamic linker. Only as precise as the clock ticks in /proc.
+    std::chrono::milliseconds sinceExec{-1};
+    std::chrono::milliseconds sinceMain{-1};
+    std::chrono::seconds idleTimeout = defaultIdleTimeout;
+} startup;
+
+static std::optional<std::chrono::milliseconds> processAge()
+{
+    QFile file(QStringLiteral("/proc/self/stat"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    // The command in the second field may contain anything, the fields following it don't.
+    const auto stat = file.readAll();
+    const auto fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+    // starttime is field 22, the list starts at field 3.
+    constexpr auto startTimeIndex = 22 - 3;
+    struct timespec now {
+    };
+    if (fields.size() <= startTimeIndex || clock_gettime(CLOCK_BOOTTIME, &now) != 0) {
+        return std::nullopt;
+    }
+    const std::chrono::milliseconds startTime(fields.at(startTimeIndex).toLongLong() * 1000 / sysconf(_SC_CLK_TCK));
+    const auto uptime = std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(uptime) - startTime;
+}
+
+// Not needed to take the name, only to serve commands, so it happens once the bus already routes calls to us.
+static void setUpKIO()
+{
+    qRegisterMetaType<KIO::UDSEntryList>("KIO::UDSEntryList");
+    qDBusRegisterMetaType<KIO::UDSEntryList>();
+
+    qRegisterMetaType<KIO::UDSEntry>("KIO::UDSEntry");
+    qDBusRegisterMetaType<KIO::UDSEntry>();
+
+    KIO::setDefaultJobUiDelegateFactory(nullptr);
+    KIO::setDefaultJobUiDelegateExtension(nullptr);
+}
+
+// Exits once no command was alive for \a timeout. The name is given up first, so new calls activate a fresh helper
+// while whatever is already on its way to us still gets served.
+static void exitWhenIdle(std::chrono::seconds timeout)
+{
+    auto timer = new QTimer(QCoreApplication::instance());
+    timer->setSingleShot(true);
+    timer->setInterval(timeout);
+    auto &table = CommandTable::instance();
+    QObject::connect(&table, &CommandTable::occupied, timer, &QTimer::stop);
+    QObject::connect(&table, &CommandTable::emptied, timer, qOverload<>(&QTimer::start));
+    QObject::connect(timer, &QTimer::timeout, timer, [timer, released = false]() mutable {
+        if (CommandTable::instance().size() != 0) {
+            return;
+        }
+        if (!std::exchange(released, true)) {
+            qCDebug(KIOADMIN_LOG) << "Idle, giving up the service";
+            QDBusConnection::systemBus().unregisterService(QStringLiteral("org.kde.kio.admin"));
+            timer->setInterval(exitGracePeriod);
+            timer->start();
+            return;
+        }
+        qCDebug(KIOADMIN_LOG) << "Idle, exiting";
+        QCoreApplication::quit();
+    });
+    timer->start();
+}
+
 class Helper : public QObject, protected QDBusContext
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.kde.kio.admin")
+public:
+    Helper()
+    {
+        m_subscriberWatcher.setConnection(QDBusConnection::systemBus());
+        m_subscriberWatcher.setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+        connect(&m_subscriberWatcher, &QDBusServiceWatcher::serviceUnregistered, this, [this](const QString &subscriber) {
+            m_subscriberWatcher.removeWatchedService(subscriber);
+            qDeleteAll(m_watches.take(subscriber));
+        });
+    }
+
 public Q_SLOTS:
-    QDBusObjectPath listDir(const QString &stringUrl)
+    QDBusObjectPath listDir(const QString &stringUrl, int statDetails)
     {
         if (!isAuthorized()) {
             sendErrorReply(QDBusError::AccessDenied);
             return {};
         }
 
-        static uint64_t counter = 0;
-        counter++;
-        Q_ASSERT(counter != 0);
-
-        const QDBusObjectPath objPath(QStringLiteral("/org/kde/kio/admin/listDir/%1").arg(QString::number(counter)));
-        auto command = new ListDirCommand(stringToUrl(stringUrl), message().service(), objPath);
-        connection().registerObject(objPath.path(), command, QDBusConnection::ExportAllSlots);
-        return objPath;
+        const auto objPath = reserve(QStringLiteral("listDir"));
+        if (!objPath) {
+            return {};
+        }
+        new ListDirCommand(stringToUrl(stringUrl), KIO::StatDetails(statDetails), message().service(), *objPath);
+        return *objPath;
     }
 
-    QDBusObjectPath stat(const QString &stringUrl)
+    QDBusObjectPath listDirRange(const QString &stringUrl, int statDetails, qlonglong cursor, int limit, const QString &nameFilter)
     {
         if (!isAuthorized()) {
             sendErrorReply(QDBusError::AccessDenied);
             return {};
         }
 
-        static uint64_t counter = 0;
-        counter++;
-        Q_ASSERT(counter != 0);
+        const auto objPath = reserve(QStringLiteral("listDirRange"));
+        if (!objPath) {
+            return {};
+        }
+        const LocalListJob::Range range{cursor, limit, nameFilter};
+        new ListDirCommand(stringToUrl(stringUrl), KIO::StatDetails(statDetails), range, message().service(), *objPath);
+        return *objPath;
+    }
 
-        const QDBusObjectPath objPath(QStringLiteral("/org/kde/kio/admin/stat/%1").arg(QString::number(counter)));
-        auto command = new StatCommand(stringToUrl(stringUrl), message().service(), objPath);
-        ;
-        connection().registerObject(objPath.path(), command, QDBusConnection::ExportAllSlots);
-        return objPath;
+    QDBusObjectPath stat(const QString &stringUrl, int statDetails)
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        const auto objPath = reserve(QStringLiteral("stat"));
+        if (!objPath) {
+            return {};
+        }
+        new StatCommand(stringToUrl(stringUrl), KIO::StatDetails(statDetails), message().service(), *objPath);
+        return *objPath;
     }
 
     QDBusObjectPath get(const QString &stringUrl)
@@ -81,14 +226,12 @@ public Q_SLOTS:
             return {};
         }
 
-        static uint64_t counter = 0;
-        counter++;
-        Q_ASSERT(counter != 0);
-
-        const QDBusObjectPath objPath(QStringLiteral("/org/kde/kio/admin/get/%1").arg(QString::number(counter)));
-        auto command = new GetCommand(stringToUrl(stringUrl), message().service(), objPath);
-        connection().registerObject(objPath.path(), command, QDBusConnection::ExportAllSlots);
-        return objPath;
+        const auto objPath = reserve(QStringLiteral("get"));
+        if (!objPath) {
+            return {};
+        }
+        new GetCommand(stringToUrl(stringUrl), message().service(), *objPath);
+        return *objPath;
     }
 
     QDBusObjectPath put(const QString &stringUrl, int permissions, int flags)
@@ -98,14 +241,12 @@ public Q_SLOTS:
             return {};
         }
 
-        static uint64_t counter = 0;
-        counter++;
-        Q_ASSERT(counter != 0);
-
-        const QDBusObjectPath objPath(QStringLiteral("/org/kde/kio/admin/put/%1").arg(QString::number(counter)));
-        auto command = new PutCommand(stringToUrl(stringUrl), permissions, KIO::JobFlags(flags), message().service(), objPath);
-        connection().registerObject(objPath.path(), command, QDBusConnection::ExportAllSlots);
-        return objPath;
+        const auto objPath = reserve(QStringLiteral("put"));
+        if (!objPath) {
+            return {};
+        }
+        new PutCommand(stringToUrl(stringUrl), permissions, KIO::JobFlags(flags), message().service(), *objPath);
+        return *objPath;
     }
 
     QDBusObjectPath copy(const QString &stringUrlSrc, const QString &stringUrlDst, int permissions, int flags)
@@ -115,14 +256,12 @@ public Q_SLOTS:
             return {};
         }
 
-        static uint64_t counter = 0;
-        counter++;
-        Q_ASSERT(counter != 0);
-
-        const QDBusObjectPath objPath(QStringLiteral("/org/kde/kio/admin/copy/%1").arg(QString::number(counter)));
-        auto command = new CopyCommand(stringToUrl(stringUrlSrc), stringToUrl(stringUrlDst), permissions, KIO::JobFlags(flags), message().service(), objPath);
-        connection().registerObject(objPath.path(), command, QDBusConnection::ExportAllSlots);
-        return objPath;
+        const auto objPath = reserve(QStringLiteral("copy"));
+        if (!objPath) {
+            return {};
+        }
+        new CopyCommand(stringToUrl(stringUrlSrc), stringToUrl(stringUrlDst), permissions, KIO::JobFlags(flags), message().service(), *objPath);
+        return *objPath;
     }
 
     QDBusObjectPath del(const QString &stringUrl)
@@ -132,14 +271,12 @@ public Q_SLOTS:
             return {};
         }
 
-        static uint64_t counter = 0;
-        counter++;
-        Q_ASSERT(counter != 0);
-
-        const QDBusObjectPath objPath(QStringLiteral("/org/kde/kio/admin/del/%1").arg(QString::number(counter)));
-        auto command = new DelCommand(stringToUrl(stringUrl), message().service(), objPath);
-        connection().registerObject(objPath.path(), command, QDBusConnection::ExportAllSlots);
-        return objPath;
+        const auto objPath = reserve(QStringLiteral("del"));
+        if (!objPath) {
+            return {};
+        }
+        new DelCommand(stringToUrl(stringUrl), message().service(), *objPath);
+        return *objPath;
     }
 
     QDBusObjectPath mkdir(const QString &stringUrl, int permissions)
@@ -149,14 +286,12 @@ public Q_SLOTS:
             return {};
         }
 
-        static uint64_t counter = 0;
-        counter++;
-        Q_ASSERT(counter != 0);
-
-        const QDBusObjectPath objPath(QStringLiteral("/org/kde/kio/admin/mkdir/%1").arg(QString::number(counter)));
-        auto command = new MkdirCommand(stringToUrl(stringUrl), permissions, message().service(), objPath);
-        connection().registerObject(objPath.path(), command, QDBusConnection::ExportAllSlots);
-        return objPath;
+        const auto objPath = reserve(QStringLiteral("mkdir"));
+        if (!objPath) {
+            return {};
+        }
+        new MkdirCommand(stringToUrl(stringUrl), permissions, message().service(), *objPath);
+        return *objPath;
     }
 
     QDBusObjectPath chmod(const QString &stringUrl, int permissions)
@@ -166,14 +301,12 @@ public Q_SLOTS:
             return {};
         }
 
-        static uint64_t counter = 0;
-        counter++;
-        Q_ASSERT(counter != 0);
-
-        const QDBusObjectPath objPath(QStringLiteral("/org/kde/kio/admin/chmod/%1").arg(QString::number(counter)));
-        auto command = new ChmodCommand(stringToUrl(stringUrl), permissions, message().service(), objPath);
-        connection().registerObject(objPath.path(), command, QDBusConnection::ExportAllSlots);
-        return objPath;
+        const auto objPath = reserve(QStringLiteral("chmod"));
+        if (!objPath) {
+            return {};
+        }
+        new ChmodCommand(stringToUrl(stringUrl), permissions, message().service(), *objPath);
+        return *objPath;
     }
 
     QDBusObjectPath chown(const QString &stringUrl, const QString &user, const QString &group)
@@ -183,14 +316,42 @@ public Q_SLOTS:
             return {};
         }
 
-        static uint64_t counter = 0;
-        counter++;
-        Q_ASSERT(counter != 0);
+        const auto objPath = reserve(QStringLiteral("chown"));
+        if (!objPath) {
+            return {};
+        }
+        new ChownCommand(stringToUrl(stringUrl), user, group, message().service(), *objPath);
+        return *objPath;
+    }
 
-        const QDBusObjectPath objPath(QStringLiteral("/org/kde/kio/admin/chown/%1").arg(QString::number(counter)));
-        auto command = new ChownCommand(stringToUrl(stringUrl), user, group, message().service(), objPath);
-        connection().registerObject(objPath.path(), command, QDBusConnection::ExportAllSlots);
-        return objPath;
+    QDBusObjectPath chmodTree(const QString &stringUrl, int permissions, int fileMask, int directoryMask, bool recursive)
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        const auto objPath = reserve(QStringLiteral("chmodTree"));
+        if (!objPath) {
+            return {};
+        }
+        new ChmodCommand(stringToUrl(stringUrl), permissions, fileMask, directoryMask, recursive, message().service(), *objPath);
+        return *objPath;
+    }
+
+    QDBusObjectPath chownTree(const QString &stringUrl, const QString &user, const QString &group, bool recursive)
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        const auto objPath = reserve(QStringLiteral("chownTree"));
+        if (!objPath) {
+            return {};
+        }
+        new ChownCommand(stringToUrl(stringUrl), user, group, recursive, message().service(), *objPath);
+        return *objPath;
     }
 
     QDBusObjectPath rename(const QString &stringUrlSrc, const QString &stringUrlDst, int flags)
@@ -200,14 +361,37 @@ public Q_SLOTS:
             return {};
         }
 
-        static uint64_t counter = 0;
-        counter++;
-        Q_ASSERT(counter != 0);
+        const auto objPath = reserve(QStringLiteral("rename"));
+        if (!objPath) {
+            return {};
+        }
+        new RenameCommand(stringToUrl(stringUrlSrc),
+                          stringToUrl(stringUrlDst),
+                          KIO::JobFlags(flags),
+                          RenameCommand::Operation::Rename,
+                          message().service(),
+                          *objPath);
+        return *objPath;
+    }
 
-        const QDBusObjectPath objPath(QStringLiteral("/org/kde/kio/admin/rename/%1").arg(QString::number(counter)));
-        auto command = new RenameCommand(stringToUrl(stringUrlSrc), stringToUrl(stringUrlDst), KIO::JobFlags(flags), message().service(), objPath);
-        connection().registerObject(objPath.path(), command, QDBusConnection::ExportAllSlots);
-        return objPath;
+    QDBusObjectPath exchange(const QString &stringUrlSrc, const QString &stringUrlDst)
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        const auto objPath = reserve(QStringLiteral("exchange"));
+        if (!objPath) {
+            return {};
+        }
+        new RenameCommand(stringToUrl(stringUrlSrc),
+                          stringToUrl(stringUrlDst),
+                          KIO::DefaultFlags,
+                          RenameCommand::Operation::Exchange,
+                          message().service(),
+                          *objPath);
+        return *objPath;
     }
 
     QDBusObjectPath file(const QString &stringUrl, int openMode)
@@ -217,14 +401,268 @@ public Q_SLOTS:
             return {};
         }
 
-        static uint64_t counter = 0;
-        counter++;
-        Q_ASSERT(counter != 0);
+        const auto objPath = reserve(QStringLiteral("file"), message().service(), CommandTable::Resource::File);
+        if (!objPath) {
+            return {};
+        }
+        new File(stringToUrl(stringUrl), static_cast<QIODevice::OpenMode>(openMode), message().service(), *objPath);
+        return *objPath;
+    }
 
-        const QDBusObjectPath objPath(QStringLiteral("/org/kde/kio/admin/file/%1").arg(QString::number(counter)));
-        auto command = new File(stringToUrl(stringUrl), static_cast<QIODevice::OpenMode>(openMode), message().service(), objPath);
-        connection().registerObject(objPath.path(), command, QDBusConnection::ExportAllSlots);
-        return objPath;
+    QDBusObjectPath directorySize(const QString &stringUrl)
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        const auto objPath = reserve(QStringLiteral("directorySize"));
+        if (!objPath) {
+            return {};
+        }
+        new SizeCommand(stringToUrl(stringUrl), message().service(), *objPath);
+        return *objPath;
+    }
+
+    // Zero or empty criteria don't constrain the search. \a type is one of the S_IF* file types.
+    QDBusObjectPath find(const QString &stringUrl,
+                         const QString &namePattern,
+                         int type,
+                         qlonglong minSize,
+                         qlonglong modifiedAfter,
+                         qlonglong modifiedBefore,
+                         int statDetails)
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        SearchCriteria criteria;
+        criteria.namePattern = QFile::encodeName(namePattern);
+        criteria.type = type;
+        criteria.minSize = minSize;
+        if (modifiedAfter != 0) {
+            criteria.modifiedAfter = modifiedAfter;
+        }
+        if (modifiedBefore != 0) {
+            criteria.modifiedBefore = modifiedBefore;
+        }
+
+        const auto objPath = reserve(QStringLiteral("find"));
+        if (!objPath) {
+            return {};
+        }
+        new FindCommand(stringToUrl(stringUrl), criteria, KIO::StatDetails(statDetails), message().service(), *objPath);
+        return *objPath;
+    }
+
+    // \a flags: 1 makes \a pattern a regular expression, 2 matches case insensitively. \a maxResults of 0 for no limit.
+    QDBusObjectPath grep(const QString &stringUrl, const QString &fileGlob, const QString &pattern, int flags, int maxResults)
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        ContentQuery query;
+        query.fileGlob = QFile::encodeName(fileGlob);
+        query.pattern = pattern;
+        query.regularExpression = flags & 1;
+        query.caseInsensitive = flags & 2;
+        query.maxResults = std::max(maxResults, 0);
+
+        const auto objPath = reserve(QStringLiteral("grep"));
+        if (!objPath) {
+            return {};
+        }
+        new GrepCommand(stringToUrl(stringUrl), query, message().service(), *objPath);
+        return *objPath;
+    }
+
+    // \a algorithm is one of the names checksumAlgorithm() knows, e.g. "sha256".
+    QDBusObjectPath checksum(const QString &stringUrl, const QString &algorithm)
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        const auto objPath = reserve(QStringLiteral("checksum"));
+        if (!objPath) {
+            return {};
+        }
+        new ChecksumCommand(stringToUrl(stringUrl), algorithm, message().service(), *objPath);
+        return *objPath;
+    }
+
+    QDBusObjectPath statMany(const QStringList &stringUrls, int statDetails)
+    {
+        return batch(QStringLiteral("statMany"), BatchCommand::Operation::Stat, stringUrls, {}, statDetails);
+    }
+
+    QDBusObjectPath delMany(const QStringList &stringUrls)
+    {
+        return batch(QStringLiteral("delMany"), BatchCommand::Operation::Delete, stringUrls, {}, 0);
+    }
+
+    QDBusObjectPath chmodMany(const QStringList &stringUrls, int permissions)
+    {
+        return batch(QStringLiteral("chmodMany"), BatchCommand::Operation::Chmod, stringUrls, {}, permissions);
+    }
+
+    QDBusObjectPath renameMany(const QStringList &stringUrlsSrc, const QStringList &stringUrlsDst, int flags)
+    {
+        return batch(QStringLiteral("renameMany"), BatchCommand::Operation::Rename, stringUrlsSrc, stringUrlsDst, flags);
+    }
+
+    // Hit rate and lookup latency of the uid/gid name cache, to tell whether the directory service is what makes listings slow.
+    QVariantMap identityCacheStatistics()
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        const auto statistics = IdentityCache::instance().statistics();
+        return {
+            {QStringLiteral("hits"), statistics.hits},
+            {QStringLiteral("staleHits"), statistics.staleHits},
+            {QStringLiteral("misses"), statistics.misses},
+            {QStringLiteral("lookups"), statistics.lookups},
+            {QStringLiteral("totalLookupTimeUs"), qint64(statistics.totalLookupTime.count())},
+            {QStringLiteral("maxLookupTimeUs"), qint64(statistics.maxLookupTime.count())},
+        };
+    }
+
+    // How much io_uring saves: operations vs. io_uring_enter calls. No rings means everything runs on plain syscalls.
+    QVariantMap ioUringStatistics()
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        const auto statistics = IoUring::statistics();
+        return {
+            {QStringLiteral("rings"), statistics.rings},
+            {QStringLiteral("enters"), statistics.enters},
+            {QStringLiteral("operations"), statistics.operations},
+        };
+    }
+
+    // Interactive latency under load: how long stats and listings waited for a thread, while bulk work is capped at bulkSlots.
+    QVariantMap schedulerStatistics()
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        const auto &pool = WorkStealingPool::instance();
+        const auto statistics = pool.statistics();
+        return {
+            {QStringLiteral("bulkSlots"), qulonglong(pool.bulkSlots())},
+            {QStringLiteral("interactiveTasks"), qulonglong(statistics.interactiveTasks)},
+            {QStringLiteral("bulkTasks"), qulonglong(statistics.bulkTasks)},
+            {QStringLiteral("parkedTasks"), qulonglong(statistics.parkedTasks)},
+            {QStringLiteral("totalInteractiveWaitUs"), qint64(statistics.totalInteractiveWait.count())},
+            {QStringLiteral("maxInteractiveWaitUs"), qint64(statistics.maxInteractiveWait.count())},
+        };
+    }
+
+    // How long activation took and when we exit again. sinceExecMs includes loading libraries, compare it to sinceMainMs.
+    QVariantMap startupStatistics()
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        return {
+            {QStringLiteral("sinceExecMs"), qint64(startup.sinceExec.count())},
+            {QStringLiteral("sinceMainMs"), qint64(startup.sinceMain.count())},
+            {QStringLiteral("idleTimeoutS"), qint64(startup.idleTimeout.count())},
+        };
+    }
+
+    // What every client has open and buffered, per bus name. Clients at a limit get LimitsExceeded for new commands.
+    QVariantMap clientStatistics()
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        QVariantMap clients;
+        const auto usage = CommandTable::instance().usage();
+        for (const auto &[peer, client] : usage.asKeyValueRange()) {
+            clients.insert(peer,
+                           QVariantMap{
+                               {QStringLiteral("commands"), client.commands},
+                               {QStringLiteral("files"), client.files},
+                               {QStringLiteral("bufferedBytes"), client.bufferedBytes},
+                           });
+        }
+        return clients;
+    }
+
+    // Starts sending changes of the directory to \a subscriber, which need not be the caller. A session side service
+    // may keep an eye on directories the user looks at without having to get authorized itself.
+    QDBusObjectPath watch(const QString &stringUrl, const QString &subscriber)
+    {
+        const auto url = stringToUrl(stringUrl);
+        if (!url.isLocalFile()) {
+            sendErrorReply(QDBusError::NotSupported);
+            return {};
+        }
+        // The watch lives until the subscriber leaves the bus, it had better be on it. And the changes are only for the
+        // eyes of whoever asked, not for any other user's process.
+        const auto subscriberUid = connection().interface()->serviceUid(subscriber);
+        if (!subscriberUid.isValid()) {
+            sendErrorReply(QDBusError::ServiceUnknown);
+            return {};
+        }
+        const auto callerUid = connection().interface()->serviceUid(message().service());
+        if (!callerUid.isValid() || subscriberUid.value() != callerUid.value()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+        // Every listing offers its directory again, only a new watch is worth asking polkit about.
+        if (auto command = m_watches.value(subscriber).value(stringUrl)) {
+            return command->objectPath();
+        }
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        const auto objPath = reserve(QStringLiteral("watch"), subscriber);
+        if (!objPath) {
+            return {};
+        }
+        auto command = new WatchCommand(stringUrl, url, subscriber, *objPath);
+        if (const auto error = command->start(); error != 0) {
+            delete command;
+            sendErrorReply(QDBusError::Failed, KIO::buildErrorString(error, url.toLocalFile()));
+            return {};
+        }
+        connect(command, &QObject::destroyed, this, [this, subscriber, stringUrl] {
+            if (auto it = m_watches.find(subscriber); it != m_watches.end()) {
+                it->remove(stringUrl);
+            }
+        });
+        m_watches[subscriber].insert(stringUrl, command);
+        m_subscriberWatcher.addWatchedService(subscriber);
+        return *objPath;
+    }
+
+    // Only ever ends the caller's own watches, there is nothing to authorize.
+    void unwatch(const QString &stringUrl)
+    {
+        if (auto it = m_watches.find(message().service()); it != m_watches.end()) {
+            delete it->take(stringUrl);
+        }
     }
 
 private:
@@ -232,21 +670,56 @@ private:
     {
         return ::isAuthorized(this);
     }
+
+    std::optional<QDBusObjectPath>
+    reserve(const QString &kind, const QString &peer = QString(), CommandTable::Resource resource = CommandTable::Resource::Command)
+    {
+        auto objPath = CommandTable::instance().reserve(kind, peer.isEmpty() ? message().service() : peer, resource);
+        if (!objPath) {
+            sendErrorReply(QDBusError::LimitsExceeded);
+        }
+        return objPath;
+    }
+
+    QDBusObjectPath
+    batch(const QString &name, BatchCommand::Operation operation, const QStringList &stringUrls, const QStringList &stringDestinations, int parameter)
+    {
+        if (!isAuthorized()) {
+            sendErrorReply(QDBusError::AccessDenied);
+            return {};
+        }
+
+        const auto objPath = reserve(name);
+        if (!objPath) {
+            return {};
+        }
+        new BatchCommand(operation, stringsToUrls(stringUrls), stringsToUrls(stringDestinations), parameter, message().service(), *objPath);
+        return *objPath;
+    }
+
+    // Subscriber -> watched URL -> watch
+    QHash<QString, QHash<QString, WatchCommand *>> m_watches;
+    QDBusServiceWatcher m_subscriberWatcher;
 };
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer sinceMain;
+    sinceMain.start();
+
     QCoreApplication app(argc, argv);
     app.setQuitLockEnabled(false);
 
-    qRegisterMetaType<KIO::UDSEntryList>("KIO::UDSEntryList");
-    qDBusRegisterMetaType<KIO::UDSEntryList>();
-
-    qRegisterMetaType<KIO::UDSEntry>("KIO::UDSEntry");
-    qDBusRegisterMetaType<KIO::UDSEntry>();
+    QCommandLineParser parser;
+    const QCommandLineOption idleTimeoutOption(QStringLiteral("idle-timeout"),
+                                               QStringLiteral("Exit after this many seconds without commands, 0 to never exit."),
+                                               QStringLiteral("seconds"),
+                                               QString::number(defaultIdleTimeout.count()));
+    parser.addOption(idleTimeoutOption);
+    parser.process(app);
+    startup.idleTimeout = std::chrono::seconds(parser.value(idleTimeoutOption).toUInt());
 
-    KIO::setDefaultJobUiDelegateFactory(nullptr);
-    KIO::setDefaultJobUiDelegateExtension(nullptr);
+    raiseFileDescriptorLimit();
 
     Helper helper;
 
@@ -254,10 +727,25 @@ int main(int argc, char *argv[])
         qWarning() << "Failed to register the daemon object" << QDBusConnection::systemBus().lastError().message();
         return 1;
     }
+    // Commands all live below this path, see CommandTable.
+    if (!QDBusConnection::systemBus().registerVirtualObject(CommandTable::basePath(), &CommandTable::instance(), QDBusConnection::SubPath)) {
+        qWarning() << "Failed to register the command table" << QDBusConnection::systemBus().lastError().message();
+        return 1;
+    }
     if (!QDBusConnection::systemBus().registerService(QStringLiteral("org.kde.kio.admin"))) {
         qWarning() << "Failed to register the service" << QDBusConnection::systemBus().lastError().message();
         return 1;
     }
+    setUpKIO();
+
+    // The client activating us waits all this time, see startupStatistics().
+    startup.sinceMain = std::chrono::milliseconds(sinceMain.elapsed());
+    startup.sinceExec = processAge().value_or(std::chrono::milliseconds(-1));
+    qCDebug(KIOADMIN_LOG) << "Serving" << startup.sinceExec.count() << "ms after exec," << startup.sinceMain.count() << "ms after main";
+
+    if (startup.idleTimeout.count() > 0) {
+        exitWhenIdle(startup.idleTimeout);
+    }
 
     return app.exec();
 }
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "mimetypesniffjob.h"
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+#include <QFile>
+#include <QHash>
+#include <QMimeDatabase>
+
+namespace
+{
+// Sniffing opens and reads every file, a handful of them per task is plenty of work.
+constexpr auto filesPerTask = 16;
+// Plenty for a couple of large directories. The cache is simply dropped when it grows beyond that.
+constexpr auto maxCacheSize = 16384;
+
+struct CachedMimeType {
+    qint64 size;
+    qint64 modificationTime;
+    QString mimeType;
+};
+
+std::mutex s_cacheMutex;
+QHash<QByteArray, CachedMimeType> s_cache;
+} // namespace
+
+class MimeTypeSniffer : public PoolOperation
+{
+public:
+    explicit MimeTypeSniffer(std::vector<MimeTypeSniffJob::File> files)
+        : m_files(std::move(files))
+    {
+    }
+
+    std::pair<QStringList, QStringList> takeMimeTypes()
+    {
+        std::lock_guard lock(m_mutex);
+        return {std::exchange(m_names, {}), std::exchange(m_mimeTypes, {})};
+    }
+
+protected:
+    void run() override
+    {
+        for (size_t begin = 0; begin < m_files.size(); begin += filesPerTask) {
+            const auto end = std::min(begin + filesPerTask, m_files.size());
+            schedule([self = sharedSelf<MimeTypeSniffer>(), begin, end] {
+                self->sniff(begin, end);
+            });
+        }
+    }
+
+private:
+    void sniff(size_t begin, size_t end)
+    {
+        static const QMimeDatabase database;
+        for (auto i = begin; i < end && !isCanceled(); ++i) {
+            const auto &file = m_files.at(i);
+            const auto mimeType = database.mimeTypeForFile(QFile::decodeName(file.path), QMimeDatabase::MatchContent).name();
+            {
+                std::lock_guard lock(s_cacheMutex);
+                if (s_cache.size() >= maxCacheSize) {
+                    s_cache.clear();
+                }
+                s_cache.insert(file.path, {file.size, file.modificationTime, mimeType});
+            }
+            if (mimeType != file.guessedMimeType) {
+                std::lock_guard lock(m_mutex);
+                m_names.append(file.name);
+                m_mimeTypes.append(mimeType);
+            }
+        }
+    }
+
+    const std::vector<MimeTypeSniffJob::File> m_files;
+    QStringList m_names;
+    QStringList m_mimeTypes;
+};
+
+MimeTypeSniffJob::MimeTypeSniffJob(std::vector<File> files, QObject *parent)
+    : MimeTypeSniffJob(std::make_shared<MimeTypeSniffer>(std::move(files)), parent)
+{
+}
+
+MimeTypeSniffJob::MimeTypeSniffJob(const std::shared_ptr<MimeTypeSniffer> &sniffer, QObject *parent)
+    : PoolJob(sniffer, parent)
+    , m_sniffer(sniffer)
+{
+    setPriority(WorkStealingPool::Priority::Interactive);
+}
+
+MimeTypeSniffJob::~MimeTypeSniffJob() = default;
+
+std::optional<QString> MimeTypeSniffJob::cachedMimeType(const QByteArray &path, qint64 size, qint64 modificationTime)
+{
+    std::lock_guard lock(s_cacheMutex);
+    const auto it = s_cache.constFind(path);
+    if (it == s_cache.constEnd() || it->size != size || it->modificationTime != modificationTime) {
+        return std::nullopt;
+    }
+    return it->mimeType;
+}
+
+void MimeTypeSniffJob::updateProgress()
+{
+    const auto [names, types] = m_sniffer->takeMimeTypes();
+    if (!names.isEmpty()) {
+        Q_EMIT mimeTypes(names, types);
+    }
+}
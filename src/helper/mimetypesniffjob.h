@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <QStringList>
+
+#include "pooljob.h"
+
+class MimeTypeSniffer;
+
+/**
+ * Determines mimetypes of local files by content, in the background.
+ *
+ * Listings go out with mimetypes guessed from the name first. Files get queued here and sniffed on the
+ * WorkStealingPool afterwards. Only files where the content disagrees with the guess are reported through
+ * mimeTypes(). Results are cached per path, size and mtime so the next listing can use them right away.
+ */
+class MimeTypeSniffJob : public PoolJob
+{
+    Q_OBJECT
+public:
+    struct File {
+        QString name;
+        QByteArray path;
+        qint64 size;
+        qint64 modificationTime;
+        QString guessedMimeType;
+    };
+
+    explicit MimeTypeSniffJob(std::vector<File> files, QObject *parent = nullptr);
+    ~MimeTypeSniffJob() override;
+
+    /** @returns the sniffed mimetype of \a path if it is known for this very size and modification time of the file. */
+    static std::optional<QString> cachedMimeType(const QByteArray &path, qint64 size, qint64 modificationTime);
+
+Q_SIGNALS:
+    void mimeTypes(const QStringList &names, const QStringList &mimeTypes);
+
+protected:
+    void updateProgress() override;
+
+private:
+    MimeTypeSniffJob(const std::shared_ptr<MimeTypeSniffer> &sniffer, QObject *parent);
+
+    const std::shared_ptr<MimeTypeSniffer> m_sniffer;
+};
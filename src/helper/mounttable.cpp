@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "mounttable.h"
+
+#include <condition_variable>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "../kioadmin_debug.h"
+
+namespace
+{
+// Every abandoned stat holds on to a thread. Past this many we stop trying and call every suspect unresponsive.
+constexpr qsizetype maximumHangingStats = 16;
+
+bool mayHang(const QByteArray &type)
+{
+    static const QSet<QByteArray> networkTypes = {
+        QByteArrayLiteral("9p"),
+        QByteArrayLiteral("afs"),
+        QByteArrayLiteral("ceph"),
+        QByteArrayLiteral("cifs"),
+        QByteArrayLiteral("davfs"),
+        QByteArrayLiteral("glusterfs"),
+        QByteArrayLiteral("lustre"),
+        QByteArrayLiteral("ncpfs"),
+        QByteArrayLiteral("nfs"),
+        QByteArrayLiteral("nfs4"),
+        QByteArrayLiteral("smb3"),
+        QByteArrayLiteral("smbfs"),
+    };
+    // Any FUSE filesystem is only as responsive as its daemon, local or not.
+    return networkTypes.contains(type) || type == "fuse" || type.startsWith("fuse.") || type == "fuseblk";
+}
+
+// mountinfo escapes blanks, tabs, newlines and backslashes as octal.
+QByteArray unescape(const QByteArray &field)
+{
+    QByteArray result;
+    result.reserve(field.size());
+    for (qsizetype i = 0; i < field.size(); ++i) {
+        if (field.at(i) == '\\' && i + 3 < field.size()) {
+            bool ok = false;
+            const auto character = field.mid(i + 1, 3).toInt(&ok, 8);
+            if (ok) {
+                result.append(char(character));
+                i += 3;
+                continue;
+            }
+        }
+        result.append(field.at(i));
+    }
+    return result;
+}
+
+QByteArray parentOf(const QByteArray &path)
+{
+    const auto slash = path.lastIndexOf('/');
+    return slash <= 0 ? QByteArrayLiteral("/") : path.left(slash);
+}
+} // namespace
+
+MountTable &MountTable::instance()
+{
+    // Never destroyed, abandoned stats may still come back to it at exit.
+    static auto table = new MountTable;
+    return *table;
+}
+
+QSet<QByteArray> MountTable::suspectsIn(const QByteArray &directory)
+{
+    auto normalized = directory;
+    while (normalized.size() > 1 && normalized.endsWith('/')) {
+        normalized.chop(1);
+    }
+
+    std::lock_guard lock(m_mutex);
+    refreshLocked();
+    QSet<QByteArray> names;
+    for (const auto &mountPoint : std::as_const(m_suspects)) {
+        if (mountPoint != "/" && parentOf(mountPoint) == normalized) {
+            names.insert(mountPoint.mid(mountPoint.lastIndexOf('/') + 1));
+        }
+    }
+    return names;
+}
+
+void MountTable::refreshLocked()
+{
+    if (!m_mountInfo.isValid()) {
+        m_mountInfo.reset(open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC));
+        if (!m_mountInfo.isValid()) {
+            return;
+        }
+    }
+    // The kernel flags the file with POLLPRI whenever the mount table changed since it was last read.
+    pollfd fd{m_mountInfo.get(), POLLPRI, 0};
+    if (m_loaded && (poll(&fd, 1, 0) <= 0 || !(fd.revents & (POLLPRI | POLLERR)))) {
+        return;
+    }
+
+    QByteArray content;
+    char buffer[16384];
+    lseek(m_mountInfo.get(), 0, SEEK_SET);
+    for (ssize_t length = 0; (length = read(m_mountInfo.get(), buffer, sizeof(buffer))) > 0;) {
+        content.append(buffer, length);
+    }
+
+    // ID parentID major:minor root mountPoint options [optional fields...] - type source superOptions
+    m_suspects.clear();
+    const auto lines = content.split('\n');
+    for (const auto &line : lines) {
+        const auto separator = line.indexOf(" - ");
+        if (separator < 0) {
+            continue;
+        }
+        const auto fields = line.left(separator).split(' ');
+        const auto type = line.mid(separator + 3).split(' ').value(0);
+        if (fields.size() > 4 && mayHang(type)) {
+            m_suspects.insert(unescape(fields.at(4)));
+        }
+    }
+    m_loaded = true;
+    qCDebug(KIOADMIN_LOG) << "Mount points that may not answer" << m_suspects;
+}
+
+MountTable::StatResult MountTable::statx(const QByteArray &path, int flags, unsigned int mask, struct statx &buffer, std::chrono::milliseconds timeout)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_hanging.contains(path) || m_hanging.size() >= maximumHangingStats) {
+            return StatResult::TimedOut;
+        }
+    }
+
+    struct Pending {
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done = false;
+        bool abandoned = false;
+        int result = -1;
+        int error = 0;
+        struct statx buffer {
+        };
+    };
+    auto pending = std::make_shared<Pending>();
+    std::thread([this, pending, path, flags, mask] {
+        struct statx buffer {
+        };
+        const auto result = ::statx(AT_FDCWD, path.constData(), flags, mask, &buffer);
+        const auto error = errno;
+        bool abandoned = false;
+        {
+            std::lock_guard lock(pending->mutex);
+            pending->done = true;
+            pending->result = result;
+            pending->error = error;
+            pending->buffer = buffer;
+            abandoned = pending->abandoned;
+        }
+        pending->finished.notify_one();
+        if (abandoned) {
+            finishedHanging(path);
+        }
+    }).detach();
+
+    std::unique_lock lock(pending->mutex);
+    if (!pending->finished.wait_for(lock, timeout, [&pending] {
+            return pending->done;
+        })) {
+        // Registered while still holding the lock, the thread can only unregister after us.
+        pending->abandoned = true;
+        qCWarning(KIOADMIN_LOG) << "Giving up on stat'ing" << path;
+        std::lock_guard tableLock(m_mutex);
+        m_hanging.insert(path);
+        return StatResult::TimedOut;
+    }
+    if (pending->result != 0) {
+        errno = pending->error;
+        return StatResult::Failed;
+    }
+    buffer = pending->buffer;
+    return StatResult::Ok;
+}
+
+void MountTable::finishedHanging(const QByteArray &path)
+{
+    std::lock_guard lock(m_mutex);
+    m_hanging.remove(path);
+}
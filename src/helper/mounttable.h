@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+
+#include <QByteArray>
+#include <QSet>
+
+#include <sys/stat.h>
+
+#include "fsutil.h"
+
+/**
+ * Knows which mount points may not answer and stats them without getting stuck.
+ *
+ * Network and FUSE filesystems depend on something outside the kernel. A stat of a stale NFS share or a dead FUSE
+ * daemon blocks for as long as they are gone, possibly forever. statx() here runs on a thread of its own and is
+ * abandoned after the timeout. Abandoned stats keep their thread until they return, further stats of the same path
+ * give up right away meanwhile.
+ *
+ * The mount table is read from /proc/self/mountinfo and only re-read when the kernel signals a change.
+ */
+class MountTable
+{
+public:
+    enum class StatResult { Ok, Failed, TimedOut };
+
+    static MountTable &instance();
+
+    /** @returns the names of entries in \a directory that are mount points which may not answer. */
+    QSet<QByteArray> suspectsIn(const QByteArray &directory);
+
+    /** Like statx(AT_FDCWD, \a path, ...) but gives up after \a timeout. errno is set for StatResult::Failed. */
+    StatResult statx(const QByteArray &path, int flags, unsigned int mask, struct statx &buffer, std::chrono::milliseconds timeout);
+
+private:
+    MountTable() = default;
+
+    void refreshLocked();
+    void finishedHanging(const QByteArray &path);
+
+    std::mutex m_mutex;
+    UniqueFd m_mountInfo;
+    bool m_loaded = false;
+    QSet<QByteArray> m_suspects;
+    // Paths with a stat still stuck in the kernel.
+    QSet<QByteArray> m_hanging;
+};
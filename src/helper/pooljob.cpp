@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "pooljob.h"
+
+#include <chrono>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QPointer>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+constexpr auto progressInterval = 250ms;
+} // namespace
+
+void PoolOperation::start(std::function<void()> onFinished, WorkStealingPool::Priority priority, const QString &client)
+{
+    const auto onGroupFinished = [weakSelf = weak_from_this(), onFinished = std::move(onFinished)] {
+        // Only the job keeps us alive once all tasks are done. No job, nobody to tell.
+        if (auto self = weakSelf.lock()) {
+            self->finished();
+            onFinished();
+        }
+    };
+    m_group = TaskGroup::create(onGroupFinished, priority, client.toStdString());
+    m_group->run([self = shared_from_this()] {
+        self->run();
+    });
+}
+
+void PoolOperation::cancel()
+{
+    if (m_group) {
+        m_group->cancel();
+    }
+}
+
+bool PoolOperation::isCanceled() const
+{
+    return m_group->isCanceled();
+}
+
+int PoolOperation::error() const
+{
+    return m_error;
+}
+
+QString PoolOperation::errorText() const
+{
+    return m_errorText;
+}
+
+void PoolOperation::schedule(WorkStealingPool::Task task)
+{
+    m_group->run(std::move(task));
+}
+
+void PoolOperation::fail(int error, const QByteArray &path)
+{
+    reportError(error, path);
+    m_group->cancel();
+}
+
+void PoolOperation::reportError(int error, const QByteArray &path)
+{
+    std::lock_guard lock(m_mutex);
+    if (m_error == 0) {
+        m_error = error;
+        m_errorText = QFile::decodeName(path);
+    }
+}
+
+PoolJob::PoolJob(std::shared_ptr<PoolOperation> operation, QObject *parent)
+    : KJob(parent)
+    , m_operation(std::move(operation))
+{
+    m_progressTimer.setInterval(progressInterval);
+    connect(&m_progressTimer, &QTimer::timeout, this, &PoolJob::updateProgress);
+}
+
+PoolJob::~PoolJob() = default;
+
+void PoolJob::start()
+{
+    m_progressTimer.start();
+    const auto onFinished = [job = QPointer(this)] {
+        // Called from the pool, bounce to the thread the job lives in. The job may get killed in the meantime.
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [job] {
+                if (job) {
+                    job->finish();
+                }
+            },
+            Qt::QueuedConnection);
+    };
+    m_operation->start(onFinished, m_priority, m_client);
+}
+
+void PoolJob::setPriority(WorkStealingPool::Priority priority)
+{
+    m_priority = priority;
+}
+
+void PoolJob::setClient(const QString &client)
+{
+    m_client = client;
+}
+
+bool PoolJob::doKill()
+{
+    m_operation->cancel();
+    return true;
+}
+
+void PoolJob::updateProgress()
+{
+}
+
+void PoolJob::finish()
+{
+    m_progressTimer.stop();
+    updateProgress();
+    if (m_operation->error() != 0) {
+        setError(m_operation->error());
+        setErrorText(m_operation->errorText());
+    }
+    emitResult();
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <QString>
+#include <QTimer>
+
+#include <KJob>
+
+#include "workstealingpool.h"
+
+/**
+ * The part of a PoolJob that runs on the WorkStealingPool.
+ *
+ * Operations are shared between the job and their in-flight tasks so a killed job can go away while tasks are still
+ * winding down. The first fail() wins and cancels all remaining work.
+ */
+class PoolOperation : public std::enable_shared_from_this<PoolOperation>
+{
+public:
+    virtual ~PoolOperation() = default;
+
+    void start(std::function<void()> onFinished, WorkStealingPool::Priority priority, const QString &client);
+    void cancel();
+    [[nodiscard]] bool isCanceled() const;
+
+    // Only to be read once the operation has finished.
+    [[nodiscard]] int error() const;
+    [[nodiscard]] QString errorText() const;
+
+protected:
+    /** The first task of the operation. */
+    virtual void run() = 0;
+    /** Invoked on the pool after the last task has returned, unless the job was killed in the meantime. */
+    virtual void finished()
+    {
+    }
+
+    void schedule(WorkStealingPool::Task task);
+    /** Records the error for the result and cancels all remaining work. */
+    void fail(int error, const QByteArray &path);
+    /** Records the error for the result but lets the operation carry on. */
+    void reportError(int error, const QByteArray &path);
+
+    template<typename T>
+    std::shared_ptr<T> sharedSelf()
+    {
+        return std::static_pointer_cast<T>(shared_from_this());
+    }
+
+    std::mutex m_mutex;
+
+private:
+    std::shared_ptr<TaskGroup> m_group;
+    int m_error = 0;
+    QString m_errorText;
+};
+
+/**
+ * A KJob driving a PoolOperation. Progress is polled from the operation on the job's thread, the result is emitted
+ * there as well.
+ *
+ * Jobs run as bulk work unless they say otherwise, only what a view waits for should be interactive.
+ */
+class PoolJob : public KJob
+{
+    Q_OBJECT
+public:
+    ~PoolJob() override;
+
+    void start() override;
+
+    /** Call before start(). */
+    void setPriority(WorkStealingPool::Priority priority);
+    /** Whom the job works for, bulk work is shared fairly between clients. Call before start(). */
+    void setClient(const QString &client);
+
+protected:
+    explicit PoolJob(std::shared_ptr<PoolOperation> operation, QObject *parent = nullptr);
+
+    bool doKill() override;
+    /** Called periodically and once more right before the result gets emitted. */
+    virtual void updateProgress();
+
+private:
+    void finish();
+
+    const std::shared_ptr<PoolOperation> m_operation;
+    QTimer m_progressTimer;
+    WorkStealingPool::Priority m_priority = WorkStealingPool::Priority::Bulk;
+    QString m_client;
+};
@@ -3,8 +3,28 @@
 
 #include "putcommand.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <QFile>
+#include <QHash>
+
 #include <KIO/TransferJob>
 
+#include "checksumjob.h"
+#include "fsutil.h"
+#include "groupsync.h"
+#include "syncjob.h"
+
+namespace
+{
+// A single hole() never stands for more than the worker reads from its client in one go, this is merely a sanity limit.
+constexpr qulonglong maximumHoleLength = 64 * 1024 * 1024;
+} // namespace
+
 PutCommand::PutCommand(const QUrl &url, int permissions, KIO::JobFlags flags, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
     : BusObject(remoteService, objectPath, parent)
     , m_url(url)
@@ -23,18 +43,82 @@ void PutCommand::start()
 
     auto job = KIO::put(m_url, m_permissions, m_flags);
     setParent(job);
-    connect(job, &KIO::TransferJob::dataReq, this, [this](KIO::Job *, QByteArray &data) {
+    m_started = true;
+    connect(job, &KIO::TransferJob::dataReq, this, [this, job](KIO::Job *, QByteArray &data) {
         qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO << "data request";
         sendSignal(&PutCommand::dataRequest);
         m_loop.exec();
-        data = m_newData;
+        if (m_reaped) {
+            // Handing KIO no data would complete the file, only a kill leaves it as incomplete as it is.
+            job->kill();
+            return;
+        }
+        data = std::exchange(m_newData, {});
+        releaseBuffer(data.size());
+        if (m_hash) {
+            m_hash->addData(data);
+        }
+        if (m_newDataIsHole) {
+            if (m_holes.empty()) {
+                rememberWrittenFile();
+            }
+            if (!m_holes.empty() && m_holes.back().second == m_written) {
+                m_holes.back().second += data.size();
+            } else {
+                m_holes.emplace_back(m_written, m_written + data.size());
+            }
+        }
+        m_written += data.size();
     });
     connect(job, &KIO::TransferJob::result, this, [this, job](KJob *) {
         qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO << "result" << job->errorString();
-        sendSignal(&PutCommand::result, job->error(), job->errorString());
+        if (job->error() != KJob::NoError) {
+            finish(job->error(), job->errorString());
+            return;
+        }
+        // Resumed uploads append, our offsets don't relate to the file then.
+        if (!m_holes.empty() && !(m_flags & KIO::Resume)) {
+            punchHoles();
+        }
+        makeDurable();
     });
 }
 
+void PutCommand::makeDurable()
+{
+    if (m_durability == Durability::None || !m_url.isLocalFile()) {
+        finish(KJob::NoError, QString());
+        return;
+    }
+
+    const auto path = QFile::encodeName(m_url.toLocalFile());
+    if (m_durability == Durability::Group) {
+        // The transfer job goes away after its result, we have to wait for the group though.
+        setParent(static_cast<KJob *>(nullptr));
+        GroupSync::instance().sync(path, this, [this](int error, const QString &errorText) {
+            finish(error, errorText);
+            deleteLater();
+        });
+        return;
+    }
+
+    const auto scope = m_durability == Durability::Directory ? SyncJob::Scope::FilesAndDirectories : SyncJob::Scope::Files;
+    auto job = new SyncJob({path}, scope);
+    setParent(job);
+    connect(job, &KJob::result, this, [this, job] {
+        finish(job->error(), job->errorText());
+    });
+    job->start();
+}
+
+void PutCommand::finish(int error, const QString &errorString)
+{
+    if (m_hash && error == KJob::NoError) {
+        sendSignal(&PutCommand::checksum, QString::fromLatin1(m_hash->result().toHex()));
+    }
+    sendSignal(&PutCommand::result, error, errorString);
+}
+
 void PutCommand::data(const QByteArray &data)
 {
     qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
@@ -43,10 +127,146 @@ void PutCommand::data(const QByteArray &data)
         return;
     }
 
+    if (!reserveNewData(data.size())) {
+        return;
+    }
     m_newData = data;
+    m_newDataIsHole = false;
     m_loop.quit();
 }
 
+void PutCommand::setDurability(const QString &level)
+{
+    if (!isAuthorized()) {
+        sendErrorReply(QDBusError::AccessDenied);
+        return;
+    }
+
+    static const QHash<QString, Durability> levels = {
+        {QStringLiteral("none"), Durability::None},
+        {QStringLiteral("file"), Durability::File},
+        {QStringLiteral("directory"), Durability::Directory},
+        {QStringLiteral("group"), Durability::Group},
+    };
+    const auto it = levels.constFind(level);
+    if (it == levels.constEnd()) {
+        sendErrorReply(QDBusError::NotSupported, level);
+        return;
+    }
+    m_durability = it.value();
+}
+
+void PutCommand::hole(qulonglong length)
+{
+    qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO << length;
+    if (!isAuthorized()) {
+        sendErrorReply(QDBusError::AccessDenied);
+        return;
+    }
+    if (length == 0 || length > maximumHoleLength) {
+        sendErrorReply(QDBusError::InvalidArgs);
+        return;
+    }
+
+    // KIO::put wants the bytes regardless, the space is reclaimed once the file is complete.
+    if (!reserveNewData(qint64(length))) {
+        return;
+    }
+    m_newData = QByteArray(qsizetype(length), '\0');
+    m_newDataIsHole = true;
+    m_loop.quit();
+}
+
+void PutCommand::rememberWrittenFile()
+{
+    // The worker opens its file before asking for data, possibly under a .part name it renames once complete.
+    if (!m_url.isLocalFile()) {
+        return;
+    }
+    const auto path = QFile::encodeName(m_url.toLocalFile());
+    for (const QByteArray &candidate : {QByteArray(path + ".part"), path}) {
+        struct stat stat {
+        };
+        if (lstat(candidate.constData(), &stat) == 0 && S_ISREG(stat.st_mode)) {
+            m_writtenFile.emplace(stat.st_dev, stat.st_ino);
+            return;
+        }
+    }
+}
+
+void PutCommand::punchHoles()
+{
+    // Writing the zeros and deallocating them afterwards is the best we can do through KIO::put, which can't seek.
+    if (!m_url.isLocalFile() || !m_writtenFile) {
+        return;
+    }
+    const auto path = QFile::encodeName(m_url.toLocalFile());
+    // Whatever got put in place of the written file since, we don't touch it. Non-blocking in case that is a FIFO.
+    UniqueFd fd(open(path.constData(), O_WRONLY | O_NONBLOCK | O_NOFOLLOW | O_NOCTTY | O_CLOEXEC));
+    struct stat stat {
+    };
+    if (!fd.isValid() || fstat(fd.get(), &stat) != 0 || !S_ISREG(stat.st_mode) || std::pair(stat.st_dev, stat.st_ino) != m_writtenFile.value()) {
+        return;
+    }
+
+    const off_t blockSize = std::max<off_t>(stat.st_blksize, 1);
+    for (const auto &[begin, end] : m_holes) {
+        // Only whole blocks can be deallocated, partial ones would merely get zeroed again.
+        const auto alignedBegin = (begin + blockSize - 1) / blockSize * blockSize;
+        const auto alignedEnd = end / blockSize * blockSize;
+        if (alignedBegin < alignedEnd && fallocate(fd.get(), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, alignedBegin, alignedEnd - alignedBegin) != 0) {
+            qCWarning(KIOADMIN_LOG) << "Failed to punch holes into" << path << strerror(errno);
+            break;
+        }
+    }
+    // Punching counts as a modification, yet the content is what the client sent, including any mtime it asked for.
+    const struct timespec times[] = {{0, UTIME_OMIT}, stat.st_mtim};
+    futimens(fd.get(), times);
+}
+
+void PutCommand::setChecksumAlgorithm(const QString &algorithm)
+{
+    if (!isAuthorized()) {
+        sendErrorReply(QDBusError::AccessDenied);
+        return;
+    }
+
+    const auto hashAlgorithm = checksumAlgorithm(algorithm);
+    if (!hashAlgorithm) {
+        sendErrorReply(QDBusError::NotSupported, algorithm);
+        return;
+    }
+    m_hash.emplace(hashAlgorithm.value());
+}
+
+bool PutCommand::reserveNewData(qint64 size)
+{
+    // A well-behaved client sends once per dataRequest(), anything it sends beyond replaces the previous data.
+    releaseBuffer(std::exchange(m_newData, {}).size());
+    if (!acquireBuffer(size)) {
+        sendErrorReply(QDBusError::LimitsExceeded);
+        sendSignal(&PutCommand::result, int(KIO::ERR_OUT_OF_MEMORY), m_url.toString());
+        reap();
+        return false;
+    }
+    return true;
+}
+
+bool PutCommand::isIdle() const
+{
+    return !m_started || m_loop.isRunning();
+}
+
+void PutCommand::reap()
+{
+    if (m_loop.isRunning()) {
+        m_reaped = true;
+        m_loop.quit();
+        return;
+    }
+    BusObject::reap();
+}
+
 void PutCommand::kill()
 {
     doKill();
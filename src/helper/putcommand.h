@@ -3,6 +3,13 @@
 
 #pragma once
 
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <QCryptographicHash>
 #include <QEventLoop>
 #include <QUrl>
 
@@ -22,20 +29,54 @@ public:
                         const QDBusObjectPath &objectPath,
                         QObject *parent = nullptr);
 
+    [[nodiscard]] bool isIdle() const override;
+    void reap() override;
+
 public Q_SLOTS:
     void start();
     void kill();
     void data(const QByteArray &data);
+    /** Hashes the data on its way to disk, saving a second pass over the file. Call before start(). */
+    void setChecksumAlgorithm(const QString &algorithm);
+    /**
+     * How hard to try making the file survive a crash before reporting success: "none" leaves it to KIO::put, "file"
+     * fsyncs the file, "directory" its directory as well. "group" flushes the filesystem together with other puts
+     * finishing around the same time. Call before start().
+     */
+    void setDurability(const QString &level);
+    /** Like data() with @p length zero bytes. The written file gets holes punched in their place. */
+    void hole(qulonglong length);
 
 Q_SIGNALS:
     void dataRequest();
+    /** Hex encoded. Sent before result() when a checksum algorithm was set and the file got written. */
+    void checksum(const QString &digest);
     void result(int error, const QString &errorString);
 
 private:
+    enum class Durability { None, File, Directory, Group };
+
+    void rememberWrittenFile();
+    void punchHoles();
+    void makeDurable();
+    void finish(int error, const QString &errorString);
+    /** Makes room for the next data, accounted to the client. @returns false when it is over its limit. */
+    bool reserveNewData(qint64 size);
+
     QUrl m_url;
     const int m_permissions;
     const KIO::JobFlags m_flags;
 
+    Durability m_durability = Durability::None;
+    bool m_started = false;
+    bool m_reaped = false;
+    std::optional<QCryptographicHash> m_hash;
     QByteArray m_newData;
+    bool m_newDataIsHole = false;
+    off_t m_written = 0;
+    // Begin and end offsets of the zero runs that came in through hole().
+    std::vector<std::pair<off_t, off_t>> m_holes;
+    // Device and inode of the file KIO::put writes, holes only get punched into that very file.
+    std::optional<std::pair<dev_t, ino_t>> m_writtenFile;
     QEventLoop m_loop;
 };
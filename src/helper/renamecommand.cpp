@@ -3,11 +3,16 @@
 
 #include "renamecommand.h"
 
+#include <QFile>
+
 #include <KIO/SimpleJob>
 
+#include "fsutil.h"
+
 RenameCommand::RenameCommand(const QUrl &src,
                              const QUrl &dst,
                              KIO::JobFlags flags,
+                             Operation operation,
                              const QString &remoteService,
                              const QDBusObjectPath &objectPath,
                              QObject *parent)
@@ -15,6 +20,7 @@ RenameCommand::RenameCommand(const QUrl &src,
     , m_src(src)
     , m_dst(dst)
     , m_flags(flags)
+    , m_operation(operation)
 {
 }
 
@@ -25,9 +31,51 @@ void RenameCommand::start()
         return;
     }
 
+    if (m_src.isLocalFile() && m_dst.isLocalFile()) {
+        renameLocal();
+        return;
+    }
+
+    if (m_operation == Operation::Exchange) {
+        finish(KIO::ERR_UNSUPPORTED_ACTION, m_src.toString());
+        return;
+    }
+
     auto job = KIO::rename(m_src, m_dst, m_flags);
     setParent(job);
     connect(job, &KIO::SimpleJob::result, this, [this, job](KJob *) {
         sendSignal(&RenameCommand::result, job->error(), job->errorString());
     });
 }
+
+// A single syscall instead of the stat-then-rename of the file worker. RENAME_NOREPLACE also closes the window in which
+// dst could appear between the two.
+void RenameCommand::renameLocal()
+{
+    unsigned int flags = 0;
+    if (m_operation == Operation::Exchange) {
+        flags = RENAME_EXCHANGE;
+    } else if (!m_flags.testFlag(KIO::Overwrite)) {
+        flags = RENAME_NOREPLACE;
+    }
+
+    const auto error = renamePath(QFile::encodeName(m_src.toLocalFile()), QFile::encodeName(m_dst.toLocalFile()), flags);
+    switch (error) {
+    case KJob::NoError:
+        finish(KJob::NoError, {});
+        return;
+    case KIO::ERR_FILE_ALREADY_EXIST:
+    case KIO::ERR_DIR_ALREADY_EXIST:
+        finish(error, m_dst.toLocalFile());
+        return;
+    default:
+        finish(error, m_src.toLocalFile());
+        return;
+    }
+}
+
+void RenameCommand::finish(int error, const QString &errorString)
+{
+    sendSignal(&RenameCommand::result, error, errorString);
+    deleteLater();
+}
@@ -14,9 +14,15 @@ class RenameCommand : public BusObject
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.kde.kio.admin.RenameCommand")
 public:
+    enum class Operation {
+        Rename,
+        Exchange, ///< Atomically swap src and dst, both have to exist.
+    };
+
     explicit RenameCommand(const QUrl &src,
                            const QUrl &dst,
                            KIO::JobFlags flags,
+                           Operation operation,
                            const QString &remoteService,
                            const QDBusObjectPath &objectPath,
                            QObject *parent = nullptr);
@@ -28,7 +34,11 @@ Q_SIGNALS:
     void result(int error, const QString &errorString);
 
 private:
+    void renameLocal();
+    void finish(int error, const QString &errorString);
+
     const QUrl m_src;
     const QUrl m_dst;
     const KIO::JobFlags m_flags;
+    const Operation m_operation;
 };
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "sizecommand.h"
+
+#include <QFile>
+
+#include <KIO/Global>
+
+#include "treesizejob.h"
+
+SizeCommand::SizeCommand(const QUrl &url, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
+    : BusObject(remoteService, objectPath, parent)
+    , m_url(url)
+{
+}
+
+void SizeCommand::start()
+{
+    if (!isAuthorized()) {
+        sendErrorReply(QDBusError::AccessDenied);
+        return;
+    }
+
+    if (!m_url.isLocalFile()) {
+        sendSignal(&SizeCommand::result, int(KIO::ERR_UNSUPPORTED_ACTION), m_url.toString());
+        deleteLater();
+        return;
+    }
+
+    auto job = new TreeSizeJob(QFile::encodeName(m_url.toLocalFile()));
+    setParent(job);
+    connect(job, &TreeSizeJob::sizeChanged, this, [this](const TreeSize &size) {
+        sendSignal(&SizeCommand::totals, size.size, size.allocatedSize, size.files, size.directories);
+    });
+    connect(job, &KJob::result, this, [this, job](KJob *) {
+        if (job->error() == KJob::NoError) {
+            const auto size = job->treeSize();
+            sendSignal(&SizeCommand::totals, size.size, size.allocatedSize, size.files, size.directories);
+        }
+        sendSignal(&SizeCommand::result, job->error(), job->errorString());
+    });
+    job->start();
+}
+
+void SizeCommand::kill()
+{
+    doKill();
+}
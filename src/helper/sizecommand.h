@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <QUrl>
+
+#include "busobject.h"
+
+/** Determines the size of a directory tree without shipping its listing, see TreeSizeJob. */
+class SizeCommand : public BusObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kio.admin.SizeCommand")
+public:
+    explicit SizeCommand(const QUrl &url, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent = nullptr);
+
+public Q_SLOTS:
+    void start();
+    void kill();
+
+Q_SIGNALS:
+    /** Running totals, sent one final time before result(). */
+    void totals(qulonglong size, qulonglong allocatedSize, qulonglong files, qulonglong directories);
+    void result(int error, const QString &errorString);
+
+private:
+    const QUrl m_url;
+};
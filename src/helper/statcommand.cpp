@@ -3,12 +3,50 @@
 
 #include "statcommand.h"
 
+#include <sys/stat.h>
+
+#include <QFile>
+#include <QMimeDatabase>
+
 #include <KIO/StatJob>
 
-StatCommand::StatCommand(const QUrl &url, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
+#include "localentry.h"
+#include "localstatjob.h"
+
+StatCommand::StatCommand(const QUrl &url, KIO::StatDetails details, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
     : BusObject(remoteService, objectPath, parent)
     , m_url(url)
+    , m_details(details)
+{
+}
+
+void StatCommand::guessMimeType(KIO::UDSEntry &entry)
 {
+    if (entry.contains(KIO::UDSEntry::UDS_MIME_TYPE) || entry.contains(KIO::UDSEntry::UDS_GUESSED_MIME_TYPE)) {
+        return;
+    }
+    switch (entry.numberValue(KIO::UDSEntry::UDS_FILE_TYPE) & S_IFMT) {
+    case S_IFDIR:
+        entry.fastInsert(KIO::UDSEntry::UDS_GUESSED_MIME_TYPE, QStringLiteral("inode/directory"));
+        return;
+    case S_IFCHR:
+        entry.fastInsert(KIO::UDSEntry::UDS_GUESSED_MIME_TYPE, QStringLiteral("inode/chardevice"));
+        return;
+    case S_IFBLK:
+        entry.fastInsert(KIO::UDSEntry::UDS_GUESSED_MIME_TYPE, QStringLiteral("inode/blockdevice"));
+        return;
+    case S_IFIFO:
+        entry.fastInsert(KIO::UDSEntry::UDS_GUESSED_MIME_TYPE, QStringLiteral("inode/fifo"));
+        return;
+    case S_IFSOCK:
+        entry.fastInsert(KIO::UDSEntry::UDS_GUESSED_MIME_TYPE, QStringLiteral("inode/socket"));
+        return;
+    default:
+        break;
+    }
+    static const QMimeDatabase database;
+    const auto mimeType = database.mimeTypeForFile(entry.stringValue(KIO::UDSEntry::UDS_NAME), QMimeDatabase::MatchExtension);
+    entry.fastInsert(KIO::UDSEntry::UDS_GUESSED_MIME_TYPE, mimeType.name());
 }
 
 void StatCommand::start()
@@ -18,15 +56,40 @@ void StatCommand::start()
         return;
     }
 
+    if (m_url.isLocalFile() && canCreateLocalUDSEntry(m_details)) {
+        auto job = new LocalStatJob(QFile::encodeName(m_url.toLocalFile()), m_details);
+        setParent(job);
+        connect(job, &KJob::result, this, [this, job] {
+            if (job->error() == KJob::NoError) {
+                auto entry = job->statResult();
+                if (!m_details.testFlag(KIO::StatMimeType)) {
+                    guessMimeType(entry);
+                }
+                sendSignal(&StatCommand::statEntry, entry);
+            }
+            sendSignal(&StatCommand::result, job->error(), job->errorString());
+        });
+        job->start();
+        return;
+    }
+
     auto job = KIO::stat(m_url);
     setParent(job);
-    // Since we aren't file: proper we need to ensure that a mimetype is available. Otherwise KIO has a hard time guessing
-    // what is going on and can end up without a mimetype.
-    job->addMetaData(QStringLiteral("statDetails"), QString::number(KIO::StatDefaultDetails | KIO::StatMimeType));
+    // Determining the mimetype may mean reading file content, only do it when the client asked for it.
+    job->addMetaData(QStringLiteral("statDetails"), QString::number(m_details));
     connect(job, &KIO::StatJob::result, this, [this, job](KJob *) {
         if (job->error() == KJob::NoError) {
-            sendSignal(&StatCommand::statEntry, job->statResult());
+            auto entry = job->statResult();
+            if (!m_details.testFlag(KIO::StatMimeType)) {
+                guessMimeType(entry);
+            }
+            sendSignal(&StatCommand::statEntry, entry);
         }
         sendSignal(&StatCommand::result, job->error(), job->errorString());
     });
 }
+
+void StatCommand::kill()
+{
+    doKill();
+}
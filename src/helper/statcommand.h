@@ -5,6 +5,7 @@
 
 #include <QUrl>
 
+#include <KIO/Global>
 #include <KIO/UDSEntry>
 
 #include "busobject.h"
@@ -14,10 +15,21 @@ class StatCommand : public BusObject
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.kde.kio.admin.StatCommand")
 public:
-    explicit StatCommand(const QUrl &url, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent = nullptr);
+    explicit StatCommand(const QUrl &url,
+                         KIO::StatDetails details,
+                         const QString &remoteService,
+                         const QDBusObjectPath &objectPath,
+                         QObject *parent = nullptr);
+
+    /**
+     * Fills in UDS_GUESSED_MIME_TYPE from the name alone for entries that were stat'ed without KIO::StatMimeType.
+     * Since we aren't file: proper KIO would otherwise have a hard time guessing what is going on.
+     */
+    static void guessMimeType(KIO::UDSEntry &entry);
 
 public Q_SLOTS:
     void start();
+    void kill();
 
 Q_SIGNALS:
     void statEntry(const KIO::UDSEntry &entry);
@@ -25,4 +37,5 @@ Q_SIGNALS:
 
 private:
     QUrl m_url;
+    const KIO::StatDetails m_details;
 };
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "syncjob.h"
+
+#include <set>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <KIO/Global>
+
+#include "fsutil.h"
+
+class Syncer : public PoolOperation
+{
+public:
+    Syncer(const QList<QByteArray> &paths, SyncJob::Scope scope)
+        : m_paths(paths)
+        , m_scope(scope)
+    {
+    }
+
+protected:
+    void run() override
+    {
+        std::set<QByteArray> targets;
+        std::set<dev_t> filesystems;
+        for (const auto &path : m_paths) {
+            switch (m_scope) {
+            case SyncJob::Scope::FilesAndDirectories: {
+                const auto slash = path.lastIndexOf('/');
+                targets.insert(slash <= 0 ? QByteArray("/") : path.left(slash));
+                targets.insert(path);
+                break;
+            }
+            case SyncJob::Scope::Files:
+                targets.insert(path);
+                break;
+            case SyncJob::Scope::Filesystems: {
+                struct stat stat {
+                };
+                if (::stat(path.constData(), &stat) != 0) {
+                    fail(errnoToKIOError(errno, KIO::ERR_CANNOT_WRITE), path);
+                    return;
+                }
+                // Any file on the filesystem will do to get at it.
+                if (filesystems.insert(stat.st_dev).second) {
+                    targets.insert(path);
+                }
+                break;
+            }
+            }
+        }
+
+        for (const auto &target : targets) {
+            schedule([self = sharedSelf<Syncer>(), target] {
+                self->sync(target);
+            });
+        }
+    }
+
+private:
+    void sync(const QByteArray &path)
+    {
+        if (isCanceled()) {
+            return;
+        }
+        UniqueFd fd(open(path.constData(), O_RDONLY | O_NOCTTY | O_CLOEXEC));
+        if (!fd.isValid()) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_OPEN_FOR_WRITING), path);
+            return;
+        }
+        const auto result = m_scope == SyncJob::Scope::Filesystems ? syncfs(fd.get()) : fsync(fd.get());
+        if (result != 0) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_WRITE), path);
+        }
+    }
+
+    const QList<QByteArray> m_paths;
+    const SyncJob::Scope m_scope;
+};
+
+SyncJob::SyncJob(const QList<QByteArray> &paths, Scope scope, QObject *parent)
+    : SyncJob(std::make_shared<Syncer>(paths, scope), parent)
+{
+}
+
+SyncJob::SyncJob(const std::shared_ptr<Syncer> &syncer, QObject *parent)
+    : PoolJob(syncer, parent)
+    , m_syncer(syncer)
+{
+}
+
+SyncJob::~SyncJob() = default;
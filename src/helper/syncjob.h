@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <memory>
+
+#include <QByteArray>
+#include <QList>
+
+#include "pooljob.h"
+
+class Syncer;
+
+/** Flushes local files to stable storage on the WorkStealingPool. */
+class SyncJob : public PoolJob
+{
+    Q_OBJECT
+public:
+    enum class Scope {
+        /** fsync every file. */
+        Files,
+        /** fsync every file and, once each, the directories containing them so new names are durable too. */
+        FilesAndDirectories,
+        /** syncfs once per filesystem the files live on. Cheaper than many fsyncs when there are lots of files. */
+        Filesystems,
+    };
+
+    SyncJob(const QList<QByteArray> &paths, Scope scope, QObject *parent = nullptr);
+    ~SyncJob() override;
+
+private:
+    SyncJob(const std::shared_ptr<Syncer> &syncer, QObject *parent);
+
+    const std::shared_ptr<Syncer> m_syncer;
+};
@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "treeattributesjob.h"
+
+#include <atomic>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <QFile>
+
+#include <KIO/Global>
+
+#include "fsutil.h"
+#include "identitycache.h"
+
+class TreeAttributesChanger : public PoolOperation
+{
+public:
+    TreeAttributesChanger(const QByteArray &path, const AttributeChange &change, bool recursive)
+        : m_path(path)
+        , m_change(change)
+        , m_recursive(recursive)
+    {
+    }
+
+    std::atomic<qulonglong> processed = 0;
+
+    std::pair<QStringList, QList<int>> takeFailures()
+    {
+        std::lock_guard lock(m_mutex);
+        return {std::exchange(m_failedPaths, {}), std::exchange(m_failedErrors, {})};
+    }
+
+protected:
+    void run() override
+    {
+        if (!resolveNames()) {
+            return;
+        }
+
+        struct stat stat {
+        };
+        UniqueFd pathFd(open(m_path.constData(), O_PATH | O_NOFOLLOW | O_CLOEXEC));
+        if (!pathFd.isValid() || fstat(pathFd.get(), &stat) != 0) {
+            fail(errnoToKIOError(errno, KIO::ERR_DOES_NOT_EXIST), m_path);
+            return;
+        }
+        apply(pathFd.get(), m_path, stat);
+
+        if (!m_recursive || !S_ISDIR(stat.st_mode)) {
+            return;
+        }
+        // Through the descriptor we changed, not the path, which may lead somewhere else by now.
+        auto fd = std::make_shared<UniqueFd>(openat(pathFd.get(), ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        if (!fd->isValid()) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_ENTER_DIRECTORY), m_path);
+            return;
+        }
+        walk(fd, m_path);
+    }
+
+private:
+    bool resolveNames()
+    {
+        // These end up on disk, an expired answer won't do.
+        auto &identities = IdentityCache::instance();
+        if (!m_change.user.isEmpty()) {
+            const auto uid = identities.userId(m_change.user, false);
+            if (!uid) {
+                fail(KIO::ERR_CANNOT_CHOWN, QFile::encodeName(m_change.user));
+                return false;
+            }
+            m_change.uid = uid.value();
+        }
+        if (!m_change.group.isEmpty()) {
+            const auto gid = identities.groupId(m_change.group, false);
+            if (!gid) {
+                fail(KIO::ERR_CANNOT_CHOWN, QFile::encodeName(m_change.group));
+                return false;
+            }
+            m_change.gid = gid.value();
+        }
+        return true;
+    }
+
+    void walk(const std::shared_ptr<UniqueFd> &directoryFd, const QByteArray &directoryPath)
+    {
+        std::vector<DirectoryEntry> entries;
+        if (!readDirectory(directoryFd->get(), entries)) {
+            addFailure(errnoToKIOError(errno, KIO::ERR_CANNOT_ENTER_DIRECTORY), directoryPath);
+            return;
+        }
+
+        for (const auto &entry : entries) {
+            if (isCanceled()) {
+                return;
+            }
+            const auto path = joinPath(directoryPath, entry.name);
+            // The walk may well be in a directory users can write to. Everything is changed through a descriptor of
+            // what was stat'ed, so swapping an entry for a symlink to elsewhere in the meantime gets nowhere.
+            struct stat stat {
+            };
+            UniqueFd fd(openat(directoryFd->get(), entry.name.constData(), O_PATH | O_NOFOLLOW | O_CLOEXEC));
+            if (!fd.isValid() || fstat(fd.get(), &stat) != 0) {
+                if (errno != ENOENT) {
+                    addFailure(errnoToKIOError(errno, KIO::ERR_DOES_NOT_EXIST), path);
+                }
+                continue;
+            }
+            apply(fd.get(), path, stat);
+
+            if (S_ISDIR(stat.st_mode)) {
+                // Keeping a descriptor per pending directory could exhaust them, the name is opened again later on.
+                schedule([self = sharedSelf<TreeAttributesChanger>(), directoryFd, name = entry.name, path, device = stat.st_dev, inode = stat.st_ino] {
+                    constexpr auto flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+                    auto fd = std::make_shared<UniqueFd>(openat(directoryFd->get(), name.constData(), flags));
+                    struct stat stat {
+                    };
+                    if (!fd->isValid() || fstat(fd->get(), &stat) != 0) {
+                        self->addFailure(errnoToKIOError(errno, KIO::ERR_CANNOT_ENTER_DIRECTORY), path);
+                        return;
+                    }
+                    if (stat.st_dev != device || stat.st_ino != inode) {
+                        // Swapped for another directory since.
+                        self->addFailure(KIO::ERR_CANNOT_ENTER_DIRECTORY, path);
+                        return;
+                    }
+                    self->walk(fd, path);
+                });
+            }
+        }
+    }
+
+    /** \a fd is an O_PATH | O_NOFOLLOW descriptor of the entry \a stat is of. */
+    void apply(int fd, const QByteArray &path, const struct stat &stat)
+    {
+        // Ownership first, chown drops setuid and setgid bits which a following chmod may want to set again.
+        const bool ownerChanges = m_change.uid != static_cast<uid_t>(-1) && m_change.uid != stat.st_uid;
+        const bool groupChanges = m_change.gid != static_cast<gid_t>(-1) && m_change.gid != stat.st_gid;
+        if (ownerChanges || groupChanges) {
+            if (!chownFd(fd, m_change.uid, m_change.gid)) {
+                addFailure(errnoToKIOError(errno, KIO::ERR_CANNOT_CHOWN), path);
+            }
+        }
+
+        if (m_change.permissions && !S_ISLNK(stat.st_mode)) {
+            const auto mask = S_ISDIR(stat.st_mode) ? m_change.directoryMask : m_change.fileMask;
+            const auto oldMode = stat.st_mode & 07777;
+            const auto newMode = (oldMode & ~mask) | (m_change.permissions.value() & mask);
+            if (newMode != oldMode && !chmodFd(fd, newMode)) {
+                addFailure(errnoToKIOError(errno, KIO::ERR_CANNOT_CHMOD), path);
+            }
+        }
+
+        ++processed;
+    }
+
+    void addFailure(int error, const QByteArray &path)
+    {
+        reportError(error, path);
+        std::lock_guard lock(m_mutex);
+        m_failedPaths.append(QFile::decodeName(path));
+        m_failedErrors.append(error);
+    }
+
+    const QByteArray m_path;
+    AttributeChange m_change; // Only changes before the walk starts.
+    const bool m_recursive;
+
+    QStringList m_failedPaths;
+    QList<int> m_failedErrors;
+};
+
+TreeAttributesJob::TreeAttributesJob(const QByteArray &path, const AttributeChange &change, bool recursive, QObject *parent)
+    : TreeAttributesJob(std::make_shared<TreeAttributesChanger>(path, change, recursive), parent)
+{
+}
+
+TreeAttributesJob::TreeAttributesJob(const std::shared_ptr<TreeAttributesChanger> &changer, QObject *parent)
+    : PoolJob(changer, parent)
+    , m_changer(changer)
+{
+}
+
+TreeAttributesJob::~TreeAttributesJob() = default;
+
+void TreeAttributesJob::updateProgress()
+{
+    setProcessedAmount(KJob::Files, m_changer->processed);
+    const auto [paths, errors] = m_changer->takeFailures();
+    if (!paths.isEmpty()) {
+        Q_EMIT failures(paths, errors);
+    }
+}
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <sys/types.h>
+
+#include "pooljob.h"
+
+class TreeAttributesChanger;
+
+struct AttributeChange {
+    /** New permission bits, applied through fileMask or directoryMask: (mode & ~mask) | (permissions & mask). */
+    std::optional<mode_t> permissions;
+    mode_t fileMask = 07777;
+    mode_t directoryMask = 07777;
+    /** -1 leaves the respective id untouched, as with chown(2). */
+    uid_t uid = static_cast<uid_t>(-1);
+    gid_t gid = static_cast<gid_t>(-1);
+    /** Alternatively names, resolved through the IdentityCache once the job runs. */
+    QString user;
+    QString group;
+};
+
+/**
+ * Changes permissions and/or ownership of a local path and, optionally, of everything below it.
+ *
+ * The tree is walked in parallel on the WorkStealingPool. Symlinks are never followed; they get their ownership
+ * changed but have no permissions of their own. Failing entries don't abort the job, they are collected and reported
+ * in batches through failures(). The result carries the first failure.
+ */
+class TreeAttributesJob : public PoolJob
+{
+    Q_OBJECT
+public:
+    TreeAttributesJob(const QByteArray &path, const AttributeChange &change, bool recursive, QObject *parent = nullptr);
+    ~TreeAttributesJob() override;
+
+Q_SIGNALS:
+    void failures(const QStringList &paths, const QList<int> &errors);
+
+protected:
+    void updateProgress() override;
+
+private:
+    TreeAttributesJob(const std::shared_ptr<TreeAttributesChanger> &changer, QObject *parent);
+
+    const std::shared_ptr<TreeAttributesChanger> m_changer;
+};
@@ -0,0 +1,563 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "treecopyjob.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+
+#include <QFile>
+
+#include <KIO/Global>
+
+#include "../kioadmin_debug.h"
+#include "fsutil.h"
+
+namespace
+{
+// Small files are copied in batches so we don't pay the scheduling overhead per file.
+constexpr size_t filesPerTask = 32;
+constexpr size_t copyFileRangeChunkSize = 16 * 1024 * 1024;
+constexpr qsizetype readWriteBufferSize = 1024 * 1024;
+
+void copyExtendedAttributes(int in, int out)
+{
+    auto size = flistxattr(in, nullptr, 0);
+    if (size <= 0) {
+        return;
+    }
+    QByteArray names(size, Qt::Uninitialized);
+    size = flistxattr(in, names.data(), names.size());
+    if (size <= 0) {
+        return;
+    }
+    names.truncate(size);
+
+    const auto nameList = names.split('\0');
+    for (const auto &name : nameList) {
+        if (name.isEmpty()) {
+            continue;
+        }
+        auto valueSize = fgetxattr(in, name.constData(), nullptr, 0);
+        if (valueSize < 0) {
+            continue;
+        }
+        QByteArray value(valueSize, Qt::Uninitialized);
+        valueSize = fgetxattr(in, name.constData(), value.data(), value.size());
+        if (valueSize < 0) {
+            continue;
+        }
+        if (fsetxattr(out, name.constData(), value.constData(), valueSize, 0) != 0) {
+            qCDebug(KIOADMIN_LOG) << "Failed to copy extended attribute" << name << strerror(errno);
+        }
+    }
+}
+} // namespace
+
+class TreeCopier : public PoolOperation
+{
+public:
+    TreeCopier(const QByteArray &src, const QByteArray &dst, bool overwrite)
+        : m_src(src)
+        , m_dst(dst)
+        , m_overwrite(overwrite)
+    {
+    }
+
+    std::atomic<qulonglong> bytes = 0;
+    std::atomic<qulonglong> files = 0;
+    std::atomic<qulonglong> directories = 0;
+
+protected:
+    void run() override
+    {
+        copyRoot();
+    }
+
+    // Directory timestamps and permissions can only be applied once nothing gets written into them anymore.
+    void finished() override
+    {
+        applyDirectoryAttributes();
+    }
+
+private:
+    using SharedFd = std::shared_ptr<UniqueFd>;
+
+    struct DirectoryAttributes {
+        QByteArray path;
+        // Of the created directory, to make sure it's still the one we find at the end.
+        dev_t device;
+        ino_t inode;
+        // Of the source directory.
+        struct stat stat;
+    };
+
+    void rememberDirectoryAttributes(int dstFd, const QByteArray &path, const struct stat &stat)
+    {
+        struct stat created {
+        };
+        if (fstat(dstFd, &created) != 0) {
+            return;
+        }
+        std::lock_guard lock(m_mutex);
+        m_directoryAttributes.push_back({path, created.st_dev, created.st_ino, stat});
+    }
+
+    // Keeping a descriptor of every directory until the end could exhaust them. They are opened again, one component at
+    // a time from the destination root so no symlink can lead elsewhere.
+    UniqueFd openDestinationDirectory(const QByteArray &path)
+    {
+        UniqueFd fd(openat(m_dstRoot->get(), ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        const auto components = path.mid(m_dst.size()).split('/');
+        for (const auto &component : components) {
+            if (component.isEmpty() || !fd.isValid()) {
+                continue;
+            }
+            fd.reset(openat(fd.get(), component.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+        }
+        return fd;
+    }
+
+    void applyDirectoryAttributes()
+    {
+        if (isCanceled()) {
+            return;
+        }
+        // Deepest directories first so the timestamps of parents don't get touched after we've set them.
+        std::ranges::sort(m_directoryAttributes, [](const auto &a, const auto &b) {
+            return a.path.size() > b.path.size();
+        });
+        for (const auto &[path, device, inode, stat] : m_directoryAttributes) {
+            const auto fd = openDestinationDirectory(path);
+            struct stat current {
+            };
+            if (!fd.isValid() || fstat(fd.get(), &current) != 0 || current.st_dev != device || current.st_ino != inode) {
+                qCWarning(KIOADMIN_LOG) << "Directory got replaced, not applying attributes to" << path;
+                continue;
+            }
+            const struct timespec times[] = {stat.st_atim, stat.st_mtim};
+            if (fchown(fd.get(), stat.st_uid, stat.st_gid) != 0 || fchmod(fd.get(), stat.st_mode & 07777) != 0 || futimens(fd.get(), times) != 0) {
+                qCWarning(KIOADMIN_LOG) << "Failed to apply attributes to" << path << strerror(errno);
+            }
+        }
+        m_dstRoot.reset();
+    }
+
+    // Copying a tree into itself would go on until the disk is full. Walks up from the destination's parent by
+    // descriptor, so no spelling of the path through symlinks or .. hides that it's within the source.
+    int destinationError(const struct stat &srcStat) const
+    {
+        const auto isSource = [&srcStat](const struct stat &stat) {
+            return stat.st_dev == srcStat.st_dev && stat.st_ino == srcStat.st_ino;
+        };
+        struct stat current {
+        };
+        if (::stat(m_dst.constData(), &current) == 0 && isSource(current)) {
+            return KIO::ERR_IDENTICAL_FILES;
+        }
+        const auto slash = m_dst.lastIndexOf('/');
+        UniqueFd fd(open(slash > 0 ? m_dst.left(slash).constData() : "/", O_PATH | O_DIRECTORY | O_CLOEXEC));
+        while (fd.isValid() && fstat(fd.get(), &current) == 0) {
+            if (isSource(current)) {
+                return KIO::ERR_CANNOT_MOVE_INTO_ITSELF;
+            }
+            UniqueFd parent(openat(fd.get(), "..", O_PATH | O_DIRECTORY | O_CLOEXEC));
+            struct stat parentStat {
+            };
+            // The root is its own parent.
+            if (!parent.isValid() || fstat(parent.get(), &parentStat) != 0
+                || (parentStat.st_dev == current.st_dev && parentStat.st_ino == current.st_ino)) {
+                break;
+            }
+            fd = std::move(parent);
+        }
+        return 0;
+    }
+
+    void copyRoot()
+    {
+        UniqueFd src(open(m_src.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        struct stat stat {
+        };
+        if (!src.isValid() || fstat(src.get(), &stat) != 0) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_ENTER_DIRECTORY), m_src);
+            return;
+        }
+        if (const int error = destinationError(stat); error != 0) {
+            fail(error, m_dst);
+            return;
+        }
+        if (mkdir(m_dst.constData(), 0700) != 0 && !(errno == EEXIST && m_overwrite)) {
+            fail(errno == EEXIST ? KIO::ERR_DIR_ALREADY_EXIST : errnoToKIOError(errno, KIO::ERR_CANNOT_MKDIR), m_dst);
+            return;
+        }
+        auto dst = std::make_shared<UniqueFd>(open(m_dst.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+        if (!dst->isValid()) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_MKDIR), m_dst);
+            return;
+        }
+        m_dstRoot = dst;
+        copyExtendedAttributes(src.get(), dst->get());
+        rememberDirectoryAttributes(dst->get(), m_dst, stat);
+        ++directories;
+
+        copyDirectory(std::make_shared<UniqueFd>(std::move(src)), dst, m_src, m_dst);
+    }
+
+    void copyDirectory(const SharedFd &srcDir, const SharedFd &dstDir, const QByteArray &srcPath, const QByteArray &dstPath)
+    {
+        std::vector<DirectoryEntry> entries;
+        if (!readDirectory(srcDir->get(), entries)) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_ENTER_DIRECTORY), srcPath);
+            return;
+        }
+
+        std::vector<QByteArray> batch;
+        for (auto &entry : entries) {
+            if (isCanceled()) {
+                return;
+            }
+
+            auto type = entry.type;
+            if (type == DT_UNKNOWN) {
+                struct stat stat {
+                };
+                if (fstatat(srcDir->get(), entry.name.constData(), &stat, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(stat.st_mode)) {
+                    type = DT_DIR;
+                }
+            }
+            if (type == DT_DIR) {
+                schedule([self = sharedSelf<TreeCopier>(), srcDir, dstDir, name = entry.name, srcPath, dstPath] {
+                    self->copySubdirectory(srcDir, dstDir, name, srcPath, dstPath);
+                });
+                continue;
+            }
+
+            batch.push_back(std::move(entry.name));
+            if (batch.size() == filesPerTask) {
+                schedule([self = sharedSelf<TreeCopier>(), srcDir, dstDir, srcPath, dstPath, names = std::exchange(batch, {})] {
+                    self->copyEntries(srcDir, dstDir, srcPath, dstPath, names);
+                });
+            }
+        }
+        // The remainder is copied right here, there is little point in handing it off.
+        copyEntries(srcDir, dstDir, srcPath, dstPath, batch);
+    }
+
+    void copySubdirectory(const SharedFd &srcParent,
+                          const SharedFd &dstParent,
+                          const QByteArray &name,
+                          const QByteArray &srcParentPath,
+                          const QByteArray &dstParentPath)
+    {
+        const auto srcPath = joinPath(srcParentPath, name);
+        const auto dstPath = joinPath(dstParentPath, name);
+
+        UniqueFd src(openat(srcParent->get(), name.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+        struct stat stat {
+        };
+        if (!src.isValid() || fstat(src.get(), &stat) != 0) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_ENTER_DIRECTORY), srcPath);
+            return;
+        }
+        // Created inaccessible to everyone but root, the real permissions are applied at the very end.
+        if (mkdirat(dstParent->get(), name.constData(), 0700) != 0 && !(errno == EEXIST && m_overwrite)) {
+            fail(errno == EEXIST ? KIO::ERR_DIR_ALREADY_EXIST : errnoToKIOError(errno, KIO::ERR_CANNOT_MKDIR), dstPath);
+            return;
+        }
+        UniqueFd dst(openat(dstParent->get(), name.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+        if (!dst.isValid()) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_MKDIR), dstPath);
+            return;
+        }
+        copyExtendedAttributes(src.get(), dst.get());
+        rememberDirectoryAttributes(dst.get(), dstPath, stat);
+        ++directories;
+
+        copyDirectory(std::make_shared<UniqueFd>(std::move(src)), std::make_shared<UniqueFd>(std::move(dst)), srcPath, dstPath);
+    }
+
+    void copyEntries(const SharedFd &srcDir, const SharedFd &dstDir, const QByteArray &srcPath, const QByteArray &dstPath, const std::vector<QByteArray> &names)
+    {
+        for (const auto &name : names) {
+            if (isCanceled()) {
+                return;
+            }
+
+            struct stat stat {
+            };
+            if (fstatat(srcDir->get(), name.constData(), &stat, AT_SYMLINK_NOFOLLOW) != 0) {
+                fail(errnoToKIOError(errno, KIO::ERR_DOES_NOT_EXIST), joinPath(srcPath, name));
+                return;
+            }
+
+            switch (stat.st_mode & S_IFMT) {
+            case S_IFDIR: // Turned into a directory since we've read the parent.
+                copySubdirectory(srcDir, dstDir, name, srcPath, dstPath);
+                break;
+            case S_IFREG:
+                copyFile(srcDir->get(), dstDir->get(), name, stat, srcPath, dstPath);
+                break;
+            case S_IFLNK:
+                copySymlink(srcDir->get(), dstDir->get(), name, stat, srcPath, dstPath);
+                break;
+            default:
+                copySpecialFile(dstDir->get(), name, stat, dstPath);
+                break;
+            }
+        }
+    }
+
+    // Replaces an existing destination when we are allowed to overwrite, otherwise reports the conflict.
+    bool resolveExistingDestination(int dstDir, const QByteArray &name, const QByteArray &dstPath)
+    {
+        if (!m_overwrite) {
+            fail(KIO::ERR_FILE_ALREADY_EXIST, joinPath(dstPath, name));
+            return false;
+        }
+        if (unlinkat(dstDir, name.constData(), 0) != 0) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_DELETE), joinPath(dstPath, name));
+            return false;
+        }
+        return true;
+    }
+
+    void copyFile(int srcDir, int dstDir, const QByteArray &name, const struct stat &stat, const QByteArray &srcPath, const QByteArray &dstPath)
+    {
+        UniqueFd in(openat(srcDir, name.constData(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+        if (!in.isValid()) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_OPEN_FOR_READING), joinPath(srcPath, name));
+            return;
+        }
+        constexpr auto flags = O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC;
+        UniqueFd out(openat(dstDir, name.constData(), flags, 0600));
+        if (!out.isValid() && errno == EEXIST) {
+            if (!resolveExistingDestination(dstDir, name, dstPath)) {
+                return;
+            }
+            out.reset(openat(dstDir, name.constData(), flags, 0600));
+        }
+        if (!out.isValid()) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_OPEN_FOR_WRITING), joinPath(dstPath, name));
+            return;
+        }
+
+        if (!(isSparse(stat) ? copySparseData(in.get(), out.get(), stat.st_size) : copyData(in.get(), out.get()))) {
+            if (!isCanceled()) {
+                fail(errnoToKIOError(errno, KIO::ERR_CANNOT_WRITE), joinPath(dstPath, name));
+            }
+            return;
+        }
+
+        copyExtendedAttributes(in.get(), out.get());
+        // chown before chmod, changing the owner drops setuid and setgid bits.
+        const struct timespec times[] = {stat.st_atim, stat.st_mtim};
+        if (fchown(out.get(), stat.st_uid, stat.st_gid) != 0 || fchmod(out.get(), stat.st_mode & 07777) != 0 || futimens(out.get(), times) != 0) {
+            qCWarning(KIOADMIN_LOG) << "Failed to apply attributes to" << joinPath(dstPath, name) << strerror(errno);
+        }
+        ++files;
+    }
+
+    bool copyData(int in, int out)
+    {
+        // copy_file_range lets the kernel (or the filesystem, for reflinks and server side copies) do the heavy lifting.
+        // It is not supported across all filesystem combinations though, in which case we fall back to read/write.
+        bool anythingCopied = false;
+        while (true) {
+            if (isCanceled()) {
+                return false;
+            }
+            const auto copied = copy_file_range(in, nullptr, out, nullptr, copyFileRangeChunkSize, 0);
+            if (copied < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (!anythingCopied && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                    break;
+                }
+                return false;
+            }
+            if (copied == 0) {
+                return true;
+            }
+            anythingCopied = true;
+            bytes += copied;
+        }
+
+        QByteArray buffer(readWriteBufferSize, Qt::Uninitialized);
+        while (true) {
+            if (isCanceled()) {
+                return false;
+            }
+            const auto readBytes = read(in, buffer.data(), buffer.size());
+            if (readBytes < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if (readBytes == 0) {
+                return true;
+            }
+            for (ssize_t offset = 0; offset < readBytes;) {
+                const auto written = write(out, buffer.constData() + offset, readBytes - offset);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                offset += written;
+            }
+            bytes += readBytes;
+        }
+    }
+
+    // Only the data extents get copied, holes stay holes in the destination instead of being written out as zeros.
+    bool copySparseData(int in, int out, off_t size)
+    {
+        bool useCopyFileRange = true;
+        QByteArray buffer;
+        off_t offset = 0;
+        for (; const auto extent = nextDataExtent(in, offset, size); offset = extent->end) {
+            bytes += extent->begin - offset; // Holes are as good as copied.
+            loff_t inOffset = extent->begin;
+            loff_t outOffset = extent->begin;
+            while (inOffset < extent->end) {
+                if (isCanceled()) {
+                    return false;
+                }
+                const auto length = std::min<loff_t>(extent->end - inOffset, copyFileRangeChunkSize);
+                ssize_t copied = -1;
+                if (useCopyFileRange) {
+                    copied = copy_file_range(in, &inOffset, out, &outOffset, length, 0);
+                    if (copied < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                        useCopyFileRange = false;
+                        continue;
+                    }
+                } else {
+                    buffer.resize(readWriteBufferSize);
+                    copied = pread(in, buffer.data(), std::min<loff_t>(length, buffer.size()), inOffset);
+                    for (ssize_t written = 0; copied > 0 && written < copied;) {
+                        const auto result = pwrite(out, buffer.constData() + written, copied - written, outOffset + written);
+                        if (result < 0 && errno != EINTR) {
+                            return false;
+                        }
+                        written += std::max<ssize_t>(result, 0);
+                    }
+                    if (copied > 0) {
+                        inOffset += copied;
+                        outOffset += copied;
+                    }
+                }
+                if (copied < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                if (copied == 0) {
+                    break; // The source shrank while we were at it.
+                }
+                bytes += copied;
+            }
+        }
+        // Trailing holes don't show up as extents.
+        bytes += std::max<off_t>(size - offset, 0);
+        return ftruncate(out, size) == 0;
+    }
+
+    void copySymlink(int srcDir, int dstDir, const QByteArray &name, const struct stat &stat, const QByteArray &srcPath, const QByteArray &dstPath)
+    {
+        QByteArray target(stat.st_size > 0 ? stat.st_size + 1 : PATH_MAX, Qt::Uninitialized);
+        const auto length = readlinkat(srcDir, name.constData(), target.data(), target.size());
+        if (length < 0) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_READ), joinPath(srcPath, name));
+            return;
+        }
+        target.truncate(length);
+
+        if (symlinkat(target.constData(), dstDir, name.constData()) != 0 && errno == EEXIST) {
+            if (!resolveExistingDestination(dstDir, name, dstPath)) {
+                return;
+            }
+            if (symlinkat(target.constData(), dstDir, name.constData()) != 0) {
+                fail(errnoToKIOError(errno, KIO::ERR_CANNOT_SYMLINK), joinPath(dstPath, name));
+                return;
+            }
+        }
+        applyAttributesAt(dstDir, name, stat, dstPath);
+        ++files;
+    }
+
+    void copySpecialFile(int dstDir, const QByteArray &name, const struct stat &stat, const QByteArray &dstPath)
+    {
+        if (mknodat(dstDir, name.constData(), stat.st_mode, stat.st_rdev) != 0 && errno == EEXIST) {
+            if (!resolveExistingDestination(dstDir, name, dstPath)) {
+                return;
+            }
+            if (mknodat(dstDir, name.constData(), stat.st_mode, stat.st_rdev) != 0) {
+                fail(errnoToKIOError(errno, KIO::ERR_CANNOT_WRITE), joinPath(dstPath, name));
+                return;
+            }
+        }
+        applyAttributesAt(dstDir, name, stat, dstPath);
+        ++files;
+    }
+
+    void applyAttributesAt(int dstDir, const QByteArray &name, const struct stat &stat, const QByteArray &dstPath)
+    {
+        // Opened rather than changed by name, the destination directory may be writable by others. O_PATH doesn't
+        // follow the symlink, nor does it open a device or block on a FIFO.
+        UniqueFd fd(openat(dstDir, name.constData(), O_PATH | O_NOFOLLOW | O_CLOEXEC));
+        struct stat created {
+        };
+        if (!fd.isValid() || fstat(fd.get(), &created) != 0 || (created.st_mode & S_IFMT) != (stat.st_mode & S_IFMT)) {
+            qCWarning(KIOADMIN_LOG) << "Failed to apply attributes to" << joinPath(dstPath, name) << strerror(errno);
+            return;
+        }
+        const struct timespec times[] = {stat.st_atim, stat.st_mtim};
+        // Symlinks have no permissions of their own.
+        if (!chownFd(fd.get(), stat.st_uid, stat.st_gid) || (!S_ISLNK(stat.st_mode) && !chmodFd(fd.get(), stat.st_mode & 07777))
+            || utimensat(fd.get(), "", times, AT_EMPTY_PATH) != 0) {
+            qCWarning(KIOADMIN_LOG) << "Failed to apply attributes to" << joinPath(dstPath, name) << strerror(errno);
+        }
+    }
+
+    const QByteArray m_src;
+    const QByteArray m_dst;
+    const bool m_overwrite;
+
+    SharedFd m_dstRoot;
+    std::vector<DirectoryAttributes> m_directoryAttributes;
+};
+
+TreeCopyJob::TreeCopyJob(const QByteArray &src, const QByteArray &dst, bool overwrite, QObject *parent)
+    : TreeCopyJob(std::make_shared<TreeCopier>(src, dst, overwrite), parent)
+{
+}
+
+TreeCopyJob::TreeCopyJob(const std::shared_ptr<TreeCopier> &copier, QObject *parent)
+    : PoolJob(copier, parent)
+    , m_copier(copier)
+{
+}
+
+TreeCopyJob::~TreeCopyJob() = default;
+
+void TreeCopyJob::updateProgress()
+{
+    setProcessedAmount(KJob::Bytes, m_copier->bytes);
+    setProcessedAmount(KJob::Files, m_copier->files);
+    setProcessedAmount(KJob::Directories, m_copier->directories);
+}
@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <memory>
+
+#include "pooljob.h"
+
+class TreeCopier;
+
+/**
+ * Recursively copies a local directory tree.
+ *
+ * Unlike KIO::CopyJob, which stats, creates and copies one item at a time, the tree is walked through directory file
+ * descriptors and the work is spread across the WorkStealingPool. Ownership, permissions, timestamps and extended
+ * attributes are preserved.
+ */
+class TreeCopyJob : public PoolJob
+{
+    Q_OBJECT
+public:
+    TreeCopyJob(const QByteArray &src, const QByteArray &dst, bool overwrite, QObject *parent = nullptr);
+    ~TreeCopyJob() override;
+
+protected:
+    void updateProgress() override;
+
+private:
+    TreeCopyJob(const std::shared_ptr<TreeCopier> &copier, QObject *parent);
+
+    const std::shared_ptr<TreeCopier> m_copier;
+};
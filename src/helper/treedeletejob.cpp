@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "treedeletejob.h"
+
+#include <atomic>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <KIO/Global>
+
+#include "fsutil.h"
+
+class TreeDeleter : public PoolOperation
+{
+public:
+    explicit TreeDeleter(const QList<QByteArray> &paths)
+        : m_paths(paths)
+    {
+    }
+
+    std::atomic<qulonglong> removed = 0;
+
+protected:
+    void run() override
+    {
+        for (const auto &path : m_paths) {
+            schedule([self = sharedSelf<TreeDeleter>(), path] {
+                self->deleteRoot(path);
+            });
+        }
+    }
+
+private:
+    void deleteRoot(QByteArray path)
+    {
+        while (path.size() > 1 && path.endsWith('/')) {
+            path.chop(1);
+        }
+        const auto slash = path.lastIndexOf('/');
+        const auto name = path.mid(slash + 1);
+        if (slash < 0 || name.isEmpty()) {
+            fail(KIO::ERR_CANNOT_DELETE, path);
+            return;
+        }
+
+        auto parentFd = std::make_shared<UniqueFd>(open(slash == 0 ? "/" : path.left(slash).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        struct stat stat {
+        };
+        if (!parentFd->isValid() || fstatat(parentFd->get(), name.constData(), &stat, AT_SYMLINK_NOFOLLOW) != 0) {
+            fail(errnoToKIOError(errno, KIO::ERR_DOES_NOT_EXIST), path);
+            return;
+        }
+
+        if (!S_ISDIR(stat.st_mode)) {
+            if (unlinkat(parentFd->get(), name.constData(), 0) != 0) {
+                fail(errnoToKIOError(errno, KIO::ERR_CANNOT_DELETE), path);
+                return;
+            }
+            ++removed;
+            return;
+        }
+
+        auto root = std::make_shared<Directory>();
+        root->parentFd = parentFd;
+        root->name = name;
+        root->path = path;
+        deleteDirectory(root);
+    }
+
+    struct Directory {
+        std::shared_ptr<Directory> parent;
+        std::shared_ptr<UniqueFd> parentFd;
+        std::shared_ptr<UniqueFd> fd;
+        QByteArray name;
+        QByteArray path;
+        // The listing of the directory itself plus one for every subdirectory still being deleted.
+        std::atomic<size_t> pending = 1;
+    };
+
+    void deleteDirectory(const std::shared_ptr<Directory> &directory)
+    {
+        constexpr auto flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+        directory->fd = std::make_shared<UniqueFd>(openat(directory->parentFd->get(), directory->name.constData(), flags));
+        std::vector<DirectoryEntry> entries;
+        if (!directory->fd->isValid() || !readDirectory(directory->fd->get(), entries)) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_ENTER_DIRECTORY), directory->path);
+            return;
+        }
+
+        for (const auto &entry : entries) {
+            if (isCanceled()) {
+                return;
+            }
+            if (entry.type == DT_DIR) {
+                deleteSubdirectory(directory, entry.name);
+                continue;
+            }
+            if (unlinkat(directory->fd->get(), entry.name.constData(), 0) == 0) {
+                ++removed;
+                continue;
+            }
+            switch (errno) {
+            case EISDIR: // The filesystem didn't tell us the type.
+                deleteSubdirectory(directory, entry.name);
+                continue;
+            case ENOENT: // Someone else was faster.
+                continue;
+            default:
+                fail(errnoToKIOError(errno, KIO::ERR_CANNOT_DELETE), joinPath(directory->path, entry.name));
+                return;
+            }
+        }
+
+        complete(directory);
+    }
+
+    void deleteSubdirectory(const std::shared_ptr<Directory> &parent, const QByteArray &name)
+    {
+        auto directory = std::make_shared<Directory>();
+        directory->parent = parent;
+        directory->parentFd = parent->fd;
+        directory->name = name;
+        directory->path = joinPath(parent->path, name);
+
+        ++parent->pending;
+        schedule([self = sharedSelf<TreeDeleter>(), directory] {
+            self->deleteDirectory(directory);
+        });
+    }
+
+    // Removes the directory once the last of its subdirectories is gone, which in turn may complete the parent.
+    void complete(std::shared_ptr<Directory> directory)
+    {
+        while (directory && --directory->pending == 0) {
+            if (isCanceled()) {
+                return;
+            }
+            if (unlinkat(directory->parentFd->get(), directory->name.constData(), AT_REMOVEDIR) != 0 && errno != ENOENT) {
+                fail(errnoToKIOError(errno, KIO::ERR_CANNOT_RMDIR), directory->path);
+                return;
+            }
+            ++removed;
+            directory = directory->parent;
+        }
+    }
+
+    const QList<QByteArray> m_paths;
+};
+
+TreeDeleteJob::TreeDeleteJob(const QByteArray &path, QObject *parent)
+    : TreeDeleteJob(QList<QByteArray>{path}, parent)
+{
+}
+
+TreeDeleteJob::TreeDeleteJob(const QList<QByteArray> &paths, QObject *parent)
+    : TreeDeleteJob(std::make_shared<TreeDeleter>(paths), parent)
+{
+}
+
+TreeDeleteJob::TreeDeleteJob(const std::shared_ptr<TreeDeleter> &deleter, QObject *parent)
+    : PoolJob(deleter, parent)
+    , m_deleter(deleter)
+{
+}
+
+TreeDeleteJob::~TreeDeleteJob() = default;
+
+void TreeDeleteJob::updateProgress()
+{
+    setProcessedAmount(KJob::Files, m_deleter->removed);
+}
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <memory>
+
+#include <QList>
+
+#include "pooljob.h"
+
+class TreeDeleter;
+
+/**
+ * Deletes local files or recursively deletes directory trees.
+ *
+ * Entries are removed with unlinkat relative to their parent's directory fd, subdirectories are processed concurrently
+ * on the WorkStealingPool and removed as soon as their last child is gone. The number of removed entries is reported as
+ * KJob::Files. Several paths may be passed at once, the job stops at the first error like KIO::del does.
+ */
+class TreeDeleteJob : public PoolJob
+{
+    Q_OBJECT
+public:
+    explicit TreeDeleteJob(const QByteArray &path, QObject *parent = nullptr);
+    explicit TreeDeleteJob(const QList<QByteArray> &paths, QObject *parent = nullptr);
+    ~TreeDeleteJob() override;
+
+protected:
+    void updateProgress() override;
+
+private:
+    TreeDeleteJob(const std::shared_ptr<TreeDeleter> &deleter, QObject *parent);
+
+    const std::shared_ptr<TreeDeleter> m_deleter;
+};
@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "treesearchjob.h"
+
+#include <atomic>
+#include <utility>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <QFile>
+
+#include "fsutil.h"
+#include "localentry.h"
+#include "statcommand.h"
+
+class TreeSearcher : public PoolOperation
+{
+public:
+    TreeSearcher(const QByteArray &path, const SearchCriteria &criteria, KIO::StatDetails details)
+        : m_path(path)
+        , m_criteria(criteria)
+        , m_details(details | KIO::StatBasic | KIO::StatTime) // For the size and time criteria.
+        , m_filtersByStat(criteria.minSize > 0 || criteria.modifiedAfter != SearchCriteria().modifiedAfter
+                      || criteria.modifiedBefore != SearchCriteria().modifiedBefore)
+    {
+    }
+
+    std::atomic<qulonglong> examined = 0;
+
+    KIO::UDSEntryList takeEntries()
+    {
+        std::lock_guard lock(m_mutex);
+        return std::exchange(m_entries, {});
+    }
+
+protected:
+    void run() override
+    {
+        auto fd = std::make_shared<UniqueFd>(open(m_path.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        if (!fd->isValid()) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_ENTER_DIRECTORY), m_path);
+            return;
+        }
+        walk(fd, QByteArray());
+    }
+
+private:
+    void walk(const std::shared_ptr<UniqueFd> &directoryFd, const QByteArray &relativePath)
+    {
+        std::vector<DirectoryEntry> entries;
+        if (!readDirectory(directoryFd->get(), entries)) {
+            return;
+        }
+
+        KIO::UDSEntryList matches;
+        for (const auto &entry : entries) {
+            if (isCanceled()) {
+                return;
+            }
+            ++examined;
+            const auto relativeName = relativePath.isEmpty() ? entry.name : joinPath(relativePath, entry.name);
+
+            auto type = entry.type == DT_UNKNOWN ? mode_t(0) : mode_t(DTTOIF(entry.type));
+            if (type == 0) {
+                struct stat stat {
+                };
+                if (fstatat(directoryFd->get(), entry.name.constData(), &stat, AT_SYMLINK_NOFOLLOW) != 0) {
+                    continue;
+                }
+                type = stat.st_mode & S_IFMT;
+            }
+
+            if (type == S_IFDIR) {
+                schedule([self = sharedSelf<TreeSearcher>(), directoryFd, name = entry.name, relativeName] {
+                    constexpr auto flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+                    auto fd = std::make_shared<UniqueFd>(openat(directoryFd->get(), name.constData(), flags));
+                    if (fd->isValid()) {
+                        self->walk(fd, relativeName);
+                    }
+                });
+            }
+
+            if ((m_criteria.type != 0 && m_criteria.type != type)
+                || (!m_criteria.namePattern.isEmpty() && fnmatch(m_criteria.namePattern.constData(), entry.name.constData(), 0) != 0)) {
+                continue;
+            }
+
+            KIO::UDSEntry match;
+            if (!createLocalUDSEntry(directoryFd->get(),
+                                     entry.name,
+                                     QFile::decodeName(relativeName),
+                                     joinPath(m_path, relativeName),
+                                     m_details,
+                                     match)) {
+                continue;
+            }
+            if (m_filtersByStat && !matchesStat(match)) {
+                continue;
+            }
+            if (!m_details.testFlag(KIO::StatMimeType)) {
+                StatCommand::guessMimeType(match);
+            }
+            matches.append(std::move(match));
+        }
+
+        if (!matches.isEmpty()) {
+            std::lock_guard lock(m_mutex);
+            m_entries.append(matches);
+        }
+    }
+
+    [[nodiscard]] bool matchesStat(const KIO::UDSEntry &entry) const
+    {
+        if (m_criteria.minSize > 0 && (entry.isDir() || entry.numberValue(KIO::UDSEntry::UDS_SIZE) < m_criteria.minSize)) {
+            return false;
+        }
+        const auto modified = entry.numberValue(KIO::UDSEntry::UDS_MODIFICATION_TIME);
+        return modified >= m_criteria.modifiedAfter && modified <= m_criteria.modifiedBefore;
+    }
+
+    const QByteArray m_path;
+    const SearchCriteria m_criteria;
+    const KIO::StatDetails m_details;
+    const bool m_filtersByStat;
+    KIO::UDSEntryList m_entries;
+};
+
+TreeSearchJob::TreeSearchJob(const QByteArray &path, const SearchCriteria &criteria, KIO::StatDetails details, QObject *parent)
+    : TreeSearchJob(std::make_shared<TreeSearcher>(path, criteria, details), parent)
+{
+}
+
+TreeSearchJob::TreeSearchJob(const std::shared_ptr<TreeSearcher> &searcher, QObject *parent)
+    : PoolJob(searcher, parent)
+    , m_searcher(searcher)
+{
+}
+
+TreeSearchJob::~TreeSearchJob() = default;
+
+void TreeSearchJob::updateProgress()
+{
+    setProcessedAmount(KJob::Items, m_searcher->examined);
+    const auto list = m_searcher->takeEntries();
+    if (!list.isEmpty()) {
+        Q_EMIT entries(list);
+    }
+}
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <limits>
+#include <memory>
+
+#include <QByteArray>
+
+#include <KIO/Global>
+#include <KIO/UDSEntry>
+
+#include <sys/types.h>
+
+#include "pooljob.h"
+
+class TreeSearcher;
+
+struct SearchCriteria {
+    /** Shell glob the entry name has to match. Empty matches everything. */
+    QByteArray namePattern;
+    /** One of the S_IF* file types, 0 for any. */
+    mode_t type = 0;
+    /** Minimum size in bytes, directories are only ever matched without a minimum. */
+    qint64 minSize = 0;
+    /** Modification time range in seconds since the epoch, both ends inclusive. */
+    qint64 modifiedAfter = std::numeric_limits<qint64>::min();
+    qint64 modifiedBefore = std::numeric_limits<qint64>::max();
+};
+
+/**
+ * Searches a local directory tree for entries matching SearchCriteria.
+ *
+ * The tree is walked in parallel on the WorkStealingPool without following symlinks. Entries are only stat'ed when the
+ * directory entry itself can't tell whether they may match, so the cost beyond reading directories scales with the
+ * number of candidates. Matches are delivered in batches through entries(), their UDS_NAME is the path relative to the
+ * search root. Unreadable subdirectories are skipped.
+ */
+class TreeSearchJob : public PoolJob
+{
+    Q_OBJECT
+public:
+    TreeSearchJob(const QByteArray &path, const SearchCriteria &criteria, KIO::StatDetails details, QObject *parent = nullptr);
+    ~TreeSearchJob() override;
+
+Q_SIGNALS:
+    void entries(const KIO::UDSEntryList &list);
+
+protected:
+    void updateProgress() override;
+
+private:
+    TreeSearchJob(const std::shared_ptr<TreeSearcher> &searcher, QObject *parent);
+
+    const std::shared_ptr<TreeSearcher> m_searcher;
+};
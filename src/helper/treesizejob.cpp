@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "treesizejob.h"
+
+#include <atomic>
+#include <set>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <KIO/Global>
+
+#include "fsutil.h"
+
+class TreeSizer : public PoolOperation
+{
+public:
+    explicit TreeSizer(const QByteArray &path)
+        : m_path(path)
+    {
+    }
+
+    std::atomic<qulonglong> size = 0;
+    std::atomic<qulonglong> allocatedSize = 0;
+    std::atomic<qulonglong> files = 0;
+    std::atomic<qulonglong> directories = 0;
+
+protected:
+    void run() override
+    {
+        struct stat stat {
+        };
+        if (fstatat(AT_FDCWD, m_path.constData(), &stat, AT_SYMLINK_NOFOLLOW) != 0) {
+            fail(errnoToKIOError(errno, KIO::ERR_DOES_NOT_EXIST), m_path);
+            return;
+        }
+        if (!S_ISDIR(stat.st_mode)) {
+            add(stat);
+            return;
+        }
+        auto fd = std::make_shared<UniqueFd>(open(m_path.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+        if (!fd->isValid()) {
+            fail(errnoToKIOError(errno, KIO::ERR_CANNOT_ENTER_DIRECTORY), m_path);
+            return;
+        }
+        allocatedSize += qulonglong(stat.st_blocks) * 512;
+        walk(fd);
+    }
+
+private:
+    void walk(const std::shared_ptr<UniqueFd> &directoryFd)
+    {
+        std::vector<DirectoryEntry> entries;
+        if (!readDirectory(directoryFd->get(), entries)) {
+            return;
+        }
+
+        for (const auto &entry : entries) {
+            if (isCanceled()) {
+                return;
+            }
+            struct stat stat {
+            };
+            if (fstatat(directoryFd->get(), entry.name.constData(), &stat, AT_SYMLINK_NOFOLLOW) != 0) {
+                continue;
+            }
+            if (!S_ISDIR(stat.st_mode)) {
+                add(stat);
+                continue;
+            }
+
+            ++directories;
+            allocatedSize += qulonglong(stat.st_blocks) * 512;
+            schedule([self = sharedSelf<TreeSizer>(), directoryFd, name = entry.name] {
+                constexpr auto flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+                auto fd = std::make_shared<UniqueFd>(openat(directoryFd->get(), name.constData(), flags));
+                if (fd->isValid()) {
+                    self->walk(fd);
+                }
+            });
+        }
+    }
+
+    void add(const struct stat &stat)
+    {
+        if (stat.st_nlink > 1) {
+            std::lock_guard lock(m_mutex);
+            if (!m_seenInodes.emplace(stat.st_dev, stat.st_ino).second) {
+                return; // Another link to something we counted already.
+            }
+        }
+        ++files;
+        size += stat.st_size;
+        allocatedSize += qulonglong(stat.st_blocks) * 512;
+    }
+
+    const QByteArray m_path;
+    std::set<std::pair<dev_t, ino_t>> m_seenInodes;
+};
+
+TreeSizeJob::TreeSizeJob(const QByteArray &path, QObject *parent)
+    : TreeSizeJob(std::make_shared<TreeSizer>(path), parent)
+{
+}
+
+TreeSizeJob::TreeSizeJob(const std::shared_ptr<TreeSizer> &sizer, QObject *parent)
+    : PoolJob(sizer, parent)
+    , m_sizer(sizer)
+{
+}
+
+TreeSizeJob::~TreeSizeJob() = default;
+
+TreeSize TreeSizeJob::treeSize() const
+{
+    return m_size;
+}
+
+void TreeSizeJob::updateProgress()
+{
+    const TreeSize size{m_sizer->size, m_sizer->allocatedSize, m_sizer->files, m_sizer->directories};
+    if (size.size == m_size.size && size.files == m_size.files && size.directories == m_size.directories) {
+        return;
+    }
+    m_size = size;
+    setProcessedAmount(KJob::Bytes, size.size);
+    setProcessedAmount(KJob::Files, size.files);
+    setProcessedAmount(KJob::Directories, size.directories);
+    Q_EMIT sizeChanged(size);
+}
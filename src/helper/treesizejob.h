@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <memory>
+
+#include <QtGlobal>
+
+#include "pooljob.h"
+
+class TreeSizer;
+
+struct TreeSize {
+    /** Apparent size, as KIO::DirectorySizeJob::totalSize would have it. */
+    qulonglong size = 0;
+    /** What the tree actually occupies on disk, sparse files and filesystem blocks considered. */
+    qulonglong allocatedSize = 0;
+    /** Everything but directories, symlinks included. */
+    qulonglong files = 0;
+    /** Directories below the root. */
+    qulonglong directories = 0;
+};
+
+/**
+ * Sums up the sizes within a local directory tree.
+ *
+ * The tree is walked in parallel on the WorkStealingPool without following symlinks. Files with several hard links are
+ * counted once. Subdirectories that can't be read are skipped, only a root that can't be stat'ed fails the job.
+ * Intermediate totals are reported through sizeChanged().
+ */
+class TreeSizeJob : public PoolJob
+{
+    Q_OBJECT
+public:
+    explicit TreeSizeJob(const QByteArray &path, QObject *parent = nullptr);
+    ~TreeSizeJob() override;
+
+    [[nodiscard]] TreeSize treeSize() const;
+
+Q_SIGNALS:
+    void sizeChanged(const TreeSize &size);
+
+protected:
+    void updateProgress() override;
+
+private:
+    TreeSizeJob(const std::shared_ptr<TreeSizer> &sizer, QObject *parent);
+
+    const std::shared_ptr<TreeSizer> m_sizer;
+    TreeSize m_size;
+};
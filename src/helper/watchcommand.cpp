@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "watchcommand.h"
+
+#include <chrono>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <QSocketNotifier>
+
+#include <KIO/Global>
+
+#include "fsutil.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+// Long enough to fold a file being written into a single change, short enough for views to feel live.
+constexpr auto coalesceInterval = 200ms;
+
+constexpr uint32_t createdMask = IN_CREATE | IN_MOVED_TO;
+constexpr uint32_t deletedMask = IN_DELETE | IN_MOVED_FROM;
+constexpr uint32_t modifiedMask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE;
+constexpr uint32_t goneMask = IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED | IN_UNMOUNT;
+} // namespace
+
+// Dispatches the events of the one inotify instance to the watches by their watch descriptor.
+class Inotify
+{
+public:
+    static Inotify &instance()
+    {
+        // Never destroyed, watches still alive at exit detach from it in their destructors.
+        static auto inotify = new Inotify;
+        return *inotify;
+    }
+
+    /** @returns the watch descriptor, or -1 with errno set. */
+    int addWatch(const QByteArray &path, uint32_t mask, WatchCommand *watch)
+    {
+        if (!m_fd.isValid()) {
+            errno = ENOSYS;
+            return -1;
+        }
+        // Watching a directory twice yields the same descriptor, the watches of different subscribers share it.
+        const int descriptor = inotify_add_watch(m_fd.get(), path.constData(), mask);
+        if (descriptor >= 0) {
+            m_watches[descriptor].append(watch);
+        }
+        return descriptor;
+    }
+
+    void removeWatch(int descriptor, WatchCommand *watch)
+    {
+        auto it = m_watches.find(descriptor);
+        if (it == m_watches.end()) {
+            return; // The kernel dropped it already.
+        }
+        it->removeOne(watch);
+        if (it->isEmpty()) {
+            m_watches.erase(it);
+            inotify_rm_watch(m_fd.get(), descriptor);
+        }
+    }
+
+private:
+    Inotify()
+        : m_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+    {
+        if (!m_fd.isValid()) {
+            return;
+        }
+        m_notifier = new QSocketNotifier(m_fd.get(), QSocketNotifier::Read);
+        QObject::connect(m_notifier, &QSocketNotifier::activated, m_notifier, [this] {
+            readEvents();
+        });
+    }
+
+    void readEvents()
+    {
+        alignas(inotify_event) char buffer[4096];
+        while (true) {
+            const auto length = read(m_fd.get(), buffer, sizeof(buffer));
+            if (length <= 0) {
+                break; // EAGAIN, everything is read.
+            }
+            for (auto position = buffer; position < buffer + length;) {
+                const auto event = reinterpret_cast<const inotify_event *>(position);
+                position += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    // Not about any watch in particular, all of them may have missed something.
+                    for (const auto &watches : std::as_const(m_watches)) {
+                        for (auto watch : watches) {
+                            watch->handleEvent(*event);
+                        }
+                    }
+                    continue;
+                }
+                // Watches may end while handling, and once ignored the kernel may hand the descriptor out again.
+                const auto watches = event->mask & IN_IGNORED ? m_watches.take(event->wd) : m_watches.value(event->wd);
+                for (auto watch : watches) {
+                    watch->handleEvent(*event);
+                }
+            }
+        }
+    }
+
+    UniqueFd m_fd;
+    QSocketNotifier *m_notifier = nullptr;
+    QHash<int, QList<WatchCommand *>> m_watches;
+};
+
+WatchCommand::WatchCommand(const QString &stringUrl, const QUrl &url, const QString &remoteService, const QDBusObjectPath &objectPath, QObject *parent)
+    : BusObject(remoteService, objectPath, parent)
+    , m_stringUrl(stringUrl)
+    , m_path(QFile::encodeName(url.toLocalFile()))
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(coalesceInterval);
+    connect(&m_flushTimer, &QTimer::timeout, this, &WatchCommand::flush);
+}
+
+WatchCommand::~WatchCommand()
+{
+    if (m_watchDescriptor >= 0) {
+        Inotify::instance().removeWatch(m_watchDescriptor, this);
+    }
+}
+
+int WatchCommand::start()
+{
+    // No descriptor of the directory is kept, it would keep its filesystem from being unmounted.
+    constexpr uint32_t mask = createdMask | deletedMask | modifiedMask | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+    m_watchDescriptor = Inotify::instance().addWatch(m_path, mask, this);
+    if (m_watchDescriptor < 0) {
+        return errno == ENOSYS ? KIO::ERR_INTERNAL : errnoToKIOError(errno, KIO::ERR_CANNOT_ENTER_DIRECTORY);
+    }
+    return 0;
+}
+
+bool WatchCommand::isIdle() const
+{
+    return false;
+}
+
+void WatchCommand::handleEvent(const inotify_event &event)
+{
+    if (m_removed) {
+        return;
+    }
+    if (event.mask & IN_Q_OVERFLOW) {
+        m_overflow = true;
+    } else if (event.mask & goneMask) {
+        m_removed = true;
+        m_flushTimer.stop();
+        sendSignal(&WatchCommand::removed, m_stringUrl);
+        deleteLater();
+        return;
+    } else if (event.len > 0) { // Otherwise about the directory itself.
+        const QByteArray name(event.name);
+        if (event.mask & createdMask) {
+            addChange(name, Change::Created);
+        } else if (event.mask & deletedMask) {
+            addChange(name, Change::Deleted);
+        } else if (event.mask & modifiedMask) {
+            addChange(name, Change::Modified);
+        }
+    }
+
+    if ((!m_pending.isEmpty() || m_overflow) && !m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void WatchCommand::addChange(const QByteArray &name, Change change)
+{
+    auto it = m_pending.find(name);
+    if (it == m_pending.end()) {
+        m_pending.insert(name, change);
+    } else if (it.value() == Change::Created && change == Change::Deleted) {
+        m_pending.erase(it); // Came and went, nobody needs to know.
+    } else if (it.value() != Change::Created) {
+        it.value() = change == Change::Deleted ? Change::Deleted : Change::Modified;
+    }
+}
+
+void WatchCommand::flush()
+{
+    if (std::exchange(m_overflow, false)) {
+        m_pending.clear();
+        sendSignal(&WatchCommand::rescan, m_stringUrl);
+        return;
+    }
+
+    // Listers can't take entries from us, they stat or list what they are told about themselves. Names are all they need.
+    QStringList created;
+    QStringList modified;
+    QStringList deleted;
+    for (auto [name, change] : m_pending.asKeyValueRange()) {
+        if (change != Change::Deleted) {
+            struct stat stat {
+            };
+            if (fstatat(AT_FDCWD, joinPath(m_path, name).constData(), &stat, AT_SYMLINK_NOFOLLOW) == 0) {
+                (change == Change::Created ? created : modified).append(QFile::decodeName(name));
+                continue;
+            }
+            if (change == Change::Created) {
+                continue; // Already gone again.
+            }
+        }
+        deleted.append(QFile::decodeName(name));
+    }
+    m_pending.clear();
+
+    sendSignal(&WatchCommand::changes, m_stringUrl, created, modified, deleted);
+}
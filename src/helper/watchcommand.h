@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <QHash>
+#include <QStringList>
+#include <QTimer>
+#include <QUrl>
+
+#include "busobject.h"
+
+struct inotify_event;
+
+/**
+ * Watches a local directory with inotify and pushes what changed in it to the subscriber.
+ *
+ * Events are coalesced for a short while, then the names of the created, modified and deleted entries are sent.
+ * Unlike the other commands a watch has no result, it lives until Helper::unwatch() or until the subscriber disappears
+ * from the bus. All watches share one inotify instance, root only gets a handful of them.
+ */
+class WatchCommand : public BusObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kio.admin.WatchCommand")
+public:
+    /** \a stringUrl is passed back verbatim in all signals so the subscriber can tell its watches apart. */
+    explicit WatchCommand(const QString &stringUrl,
+                          const QUrl &url,
+                          const QString &remoteService,
+                          const QDBusObjectPath &objectPath,
+                          QObject *parent = nullptr);
+    ~WatchCommand() override;
+
+    /** @returns 0 or a KIO::Error when the directory cannot be watched. */
+    int start();
+
+    /** Watches wait on the filesystem, not on calls. They end with their subscriber. */
+    [[nodiscard]] bool isIdle() const override;
+
+Q_SIGNALS:
+    void changes(const QString &url, const QStringList &created, const QStringList &modified, const QStringList &deleted);
+    /** Events got lost, only a full listing tells what the directory looks like now. */
+    void rescan(const QString &url);
+    /** The directory itself was deleted or moved away. The watch is over. */
+    void removed(const QString &url);
+
+private:
+    friend class Inotify;
+    enum class Change { Created, Modified, Deleted };
+
+    void handleEvent(const inotify_event &event);
+    void addChange(const QByteArray &name, Change change);
+    void flush();
+
+    const QString m_stringUrl;
+    const QByteArray m_path;
+    int m_watchDescriptor = -1;
+    bool m_removed = false;
+    QTimer m_flushTimer;
+    QHash<QByteArray, Change> m_pending;
+    bool m_overflow = false;
+};
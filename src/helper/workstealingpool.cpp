@@ -0,0 +1,316 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include "workstealingpool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+// Filesystem work mostly waits on the disk, so we want more threads than cores to keep deep device queues busy.
+constexpr unsigned minimumThreadCount = 4;
+constexpr unsigned maximumThreadCount = 32;
+// Threads bulk work can never take, so a stat never waits for a copy to finish.
+constexpr unsigned minimumInteractiveThreads = 2;
+
+// From linux/ioprio.h, which not every distribution ships. Bulk work gets the lowest best-effort level rather than the
+// idle class, which could starve it entirely on a busy disk.
+constexpr int ioprioWhoProcess = 1;
+constexpr int ioprioClassShift = 13;
+constexpr int ioprioClassBestEffort = 2;
+constexpr int bulkIoPriority = (ioprioClassBestEffort << ioprioClassShift) | 7;
+// No class at all, i.e. derived from the CPU nice level like any other thread.
+constexpr int interactiveIoPriority = 0;
+
+thread_local WorkStealingPool *t_pool = nullptr;
+thread_local size_t t_queueIndex = 0;
+thread_local auto t_ioPriority = WorkStealingPool::Priority::Interactive;
+
+void setIoPriority(WorkStealingPool::Priority priority)
+{
+    if (std::exchange(t_ioPriority, priority) == priority) {
+        return;
+    }
+    // Who 0 is the calling thread. Failing merely means bulk work competes on equal terms.
+    syscall(SYS_ioprio_set, ioprioWhoProcess, 0, priority == WorkStealingPool::Priority::Bulk ? bulkIoPriority : interactiveIoPriority);
+}
+} // namespace
+
+struct WorkStealingPool::BulkClient {
+    // Guarded by m_clientsMutex.
+    size_t running = 0;
+    std::deque<Task> parked;
+    // Queued, parked and running tasks.
+    std::atomic<size_t> pending = 0;
+};
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount)
+{
+    threadCount = std::clamp(threadCount, 1U, maximumThreadCount);
+    m_bulkSlots = threadCount > minimumInteractiveThreads ? threadCount - minimumInteractiveThreads : 1;
+    for (unsigned i = 0; i < threadCount; ++i) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back([this, i] {
+            run(i);
+        });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wakeUp.notify_all();
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+}
+
+WorkStealingPool &WorkStealingPool::instance()
+{
+    // Intentionally leaked. The helper only ever ends with the process and in-flight tasks must not hold up the exit.
+    static auto pool = new WorkStealingPool(std::max(minimumThreadCount, std::thread::hardware_concurrency() * 2));
+    return *pool;
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    enqueue({std::move(task), std::chrono::steady_clock::now(), nullptr});
+}
+
+void WorkStealingPool::submit(Task task, const std::shared_ptr<BulkClient> &client)
+{
+    if (client->pending++ == 0) {
+        ++m_activeClients;
+    }
+    enqueue({std::move(task), {}, client});
+}
+
+std::shared_ptr<WorkStealingPool::BulkClient> WorkStealingPool::bulkClient(const std::string &name)
+{
+    std::lock_guard lock(m_clientsMutex);
+    if (auto client = m_clients[name].lock()) {
+        return client;
+    }
+    std::erase_if(m_clients, [](const auto &pair) {
+        return pair.second.expired();
+    });
+    auto client = std::make_shared<BulkClient>();
+    m_clients[name] = client;
+    return client;
+}
+
+size_t WorkStealingPool::bulkSlots() const
+{
+    return m_bulkSlots;
+}
+
+WorkStealingPool::Statistics WorkStealingPool::statistics() const
+{
+    return {
+        .interactiveTasks = m_interactiveTasks,
+        .bulkTasks = m_bulkTasks,
+        .parkedTasks = m_parkedTasks,
+        .totalInteractiveWait = std::chrono::microseconds(m_totalInteractiveWait),
+        .maxInteractiveWait = std::chrono::microseconds(m_maxInteractiveWait),
+    };
+}
+
+void WorkStealingPool::enqueue(Entry entry)
+{
+    auto &queued = entry.client ? m_queuedBulk : m_queuedInteractive;
+    // Count the task before it becomes visible so a thief can never observe it and decrement below zero.
+    {
+        std::lock_guard lock(m_sleepMutex);
+        ++queued;
+    }
+
+    const size_t index = t_pool == this ? t_queueIndex : m_nextQueue++ % m_queues.size();
+    {
+        auto &queue = *m_queues.at(index);
+        std::lock_guard lock(queue.mutex);
+        (entry.client ? queue.bulk : queue.interactive).push_back(std::move(entry));
+    }
+    m_wakeUp.notify_one();
+}
+
+bool WorkStealingPool::pop(size_t index, std::deque<Entry> Queue::*tasks, Entry &entry)
+{
+    {
+        auto &queue = *m_queues.at(index);
+        std::lock_guard lock(queue.mutex);
+        if (!(queue.*tasks).empty()) {
+            entry = std::move((queue.*tasks).back());
+            (queue.*tasks).pop_back();
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < m_queues.size(); ++offset) {
+        auto &queue = *m_queues.at((index + offset) % m_queues.size());
+        std::unique_lock lock(queue.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || (queue.*tasks).empty()) {
+            continue;
+        }
+        entry = std::move((queue.*tasks).front());
+        (queue.*tasks).pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool WorkStealingPool::hasRunnableWork() const
+{
+    return m_queuedInteractive > 0 || (m_queuedBulk > 0 && m_runningBulk < m_bulkSlots);
+}
+
+void WorkStealingPool::runInteractive(Entry entry)
+{
+    const auto wait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - entry.queuedAt).count();
+    ++m_interactiveTasks;
+    m_totalInteractiveWait += wait;
+    auto max = m_maxInteractiveWait.load();
+    while (wait > max && !m_maxInteractiveWait.compare_exchange_weak(max, wait)) {
+        // max got reloaded, try again.
+    }
+
+    setIoPriority(Priority::Interactive);
+    entry.task();
+}
+
+void WorkStealingPool::runBulk(Entry entry)
+{
+    const auto client = std::move(entry.client);
+    {
+        // Checked and counted under the lock, so a parked task always has a running one that unparks it.
+        std::lock_guard lock(m_clientsMutex);
+        if (client->running >= fairShare()) {
+            if (client->parked.empty()) {
+                m_parkedClients.push_back(client);
+            }
+            client->parked.push_back(std::move(entry.task));
+            ++m_parkedTasks;
+            return;
+        }
+        ++client->running;
+    }
+
+    ++m_bulkTasks;
+    setIoPriority(Priority::Bulk);
+    entry.task();
+
+    std::lock_guard lock(m_clientsMutex);
+    --client->running;
+    if (--client->pending == 0) {
+        --m_activeClients;
+    }
+    unparkLocked();
+}
+
+void WorkStealingPool::releaseBulkSlot()
+{
+    {
+        std::lock_guard lock(m_sleepMutex);
+        --m_runningBulk;
+    }
+    m_wakeUp.notify_one();
+}
+
+size_t WorkStealingPool::fairShare() const
+{
+    return std::max<size_t>(1, m_bulkSlots / std::max<size_t>(1, m_activeClients));
+}
+
+void WorkStealingPool::unparkLocked()
+{
+    // Shares grow as clients finish, so not only the client that just finished a task may get to run more.
+    const auto share = fairShare();
+    std::erase_if(m_parkedClients, [this, share](const std::shared_ptr<BulkClient> &client) {
+        for (auto free = share > client->running ? share - client->running : 0; free > 0 && !client->parked.empty(); --free) {
+            enqueue({std::move(client->parked.front()), {}, client});
+            client->parked.pop_front();
+        }
+        return client->parked.empty();
+    });
+}
+
+void WorkStealingPool::run(size_t index)
+{
+    t_pool = this;
+    t_queueIndex = index;
+
+    while (true) {
+        Entry entry;
+        if (pop(index, &Queue::interactive, entry)) {
+            --m_queuedInteractive;
+            runInteractive(std::move(entry));
+            continue;
+        }
+        // Claim a slot before looking for bulk work, so no more than bulkSlots() threads ever run any.
+        if (m_runningBulk++ < m_bulkSlots && pop(index, &Queue::bulk, entry)) {
+            --m_queuedBulk;
+            runBulk(std::move(entry));
+            releaseBulkSlot();
+            continue;
+        }
+        releaseBulkSlot();
+
+        std::unique_lock lock(m_sleepMutex);
+        m_wakeUp.wait(lock, [this] {
+            return m_stopping || hasRunnableWork();
+        });
+        if (m_stopping && m_queuedInteractive == 0 && m_queuedBulk == 0) {
+            return;
+        }
+    }
+}
+
+std::shared_ptr<TaskGroup>
+TaskGroup::create(std::function<void()> onFinished, WorkStealingPool::Priority priority, const std::string &client, WorkStealingPool &pool)
+{
+    auto bulkClient = priority == WorkStealingPool::Priority::Bulk ? pool.bulkClient(client) : nullptr;
+    return std::shared_ptr<TaskGroup>(new TaskGroup(std::move(onFinished), std::move(bulkClient), pool));
+}
+
+TaskGroup::TaskGroup(std::function<void()> onFinished, std::shared_ptr<WorkStealingPool::BulkClient> client, WorkStealingPool &pool)
+    : m_pool(pool)
+    , m_client(std::move(client))
+    , m_onFinished(std::move(onFinished))
+{
+}
+
+void TaskGroup::run(WorkStealingPool::Task task)
+{
+    ++m_outstanding;
+    auto wrapped = [self = shared_from_this(), task = std::move(task)] {
+        if (!self->isCanceled()) {
+            task();
+        }
+        if (--self->m_outstanding == 0) {
+            self->m_onFinished();
+        }
+    };
+    if (m_client) {
+        m_pool.submit(std::move(wrapped), m_client);
+    } else {
+        m_pool.submit(std::move(wrapped));
+    }
+}
+
+void TaskGroup::cancel()
+{
+    m_canceled = true;
+}
+
+bool TaskGroup::isCanceled() const
+{
+    return m_canceled;
+}
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A fixed size thread pool where every thread owns a task deque.
+ *
+ * Threads pop work from the back of their own deque and steal from the front of other deques once they run dry.
+ * Tasks submitted from inside a pool thread land in that thread's deque, so recursive work such as a directory walk
+ * stays cache-local while idle threads pick up whole subtrees from busy ones.
+ *
+ * Tasks come in two priorities. Interactive tasks, the stats and listings a view waits for, always go first. Bulk tasks
+ * such as copies and recursive deletes never occupy more than bulkSlots() threads, so some are always left for
+ * interactive work, and run at a lower I/O priority. Bulk slots are shared fairly between clients: a client with
+ * more than its share running has further tasks parked until one of its running tasks returns.
+ */
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void()>;
+
+    enum class Priority { Interactive, Bulk };
+
+    /** The bulk work of one client, see bulkClient(). */
+    struct BulkClient;
+
+    struct Statistics {
+        size_t interactiveTasks = 0;
+        size_t bulkTasks = 0;
+        size_t parkedTasks = 0;
+        // Time interactive tasks spent queued before a thread picked them up.
+        std::chrono::microseconds totalInteractiveWait{0};
+        std::chrono::microseconds maxInteractiveWait{0};
+    };
+
+    explicit WorkStealingPool(unsigned threadCount);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    /** The pool shared by all native operations of the helper. Threads are only spawned on first use. */
+    static WorkStealingPool &instance();
+
+    void submit(Task task);
+    /** Queues \a task as bulk work of \a client. */
+    void submit(Task task, const std::shared_ptr<BulkClient> &client);
+
+    /** @returns the handle for bulk work of the client called \a name. Clients sharing a name share their slots. */
+    std::shared_ptr<BulkClient> bulkClient(const std::string &name);
+
+    [[nodiscard]] size_t bulkSlots() const;
+    [[nodiscard]] Statistics statistics() const;
+
+private:
+    struct Entry {
+        Task task;
+        std::chrono::steady_clock::time_point queuedAt;
+        // Only set for bulk tasks.
+        std::shared_ptr<BulkClient> client;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Entry> interactive;
+        std::deque<Entry> bulk;
+    };
+
+    void enqueue(Entry entry);
+    bool pop(size_t index, std::deque<Entry> Queue::*tasks, Entry &entry);
+    [[nodiscard]] bool hasRunnableWork() const;
+    void runInteractive(Entry entry);
+    void runBulk(Entry entry);
+    void releaseBulkSlot();
+    [[nodiscard]] size_t fairShare() const;
+    void unparkLocked();
+    void run(size_t index);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeUp;
+    std::atomic<size_t> m_queuedInteractive = 0;
+    std::atomic<size_t> m_queuedBulk = 0;
+    std::atomic<size_t> m_runningBulk = 0;
+    std::atomic<size_t> m_nextQueue = 0;
+    size_t m_bulkSlots = 1;
+    bool m_stopping = false;
+
+    // Guards the clients, their running counts and parked tasks.
+    std::mutex m_clientsMutex;
+    std::unordered_map<std::string, std::weak_ptr<BulkClient>> m_clients;
+    // Clients with queued, parked or running bulk work.
+    std::atomic<size_t> m_activeClients = 0;
+    std::vector<std::shared_ptr<BulkClient>> m_parkedClients;
+
+    std::atomic<size_t> m_interactiveTasks = 0;
+    std::atomic<size_t> m_bulkTasks = 0;
+    std::atomic<size_t> m_parkedTasks = 0;
+    std::atomic<int64_t> m_totalInteractiveWait = 0;
+    std::atomic<int64_t> m_maxInteractiveWait = 0;
+};
+
+/**
+ * Book-keeping for all tasks belonging to one operation.
+ *
+ * The finished callback is invoked exactly once, on a pool thread, after the last task of the group has returned.
+ * Tasks may schedule further tasks into their own group. Cancelling the group skips all tasks that have not started yet;
+ * running tasks are expected to poll isCanceled() at reasonable intervals. All tasks of a group share its priority.
+ */
+class TaskGroup : public std::enable_shared_from_this<TaskGroup>
+{
+public:
+    /** \a client only matters to bulk groups, it names who the work is done for. */
+    static std::shared_ptr<TaskGroup> create(std::function<void()> onFinished,
+                                             WorkStealingPool::Priority priority = WorkStealingPool::Priority::Interactive,
+                                             const std::string &client = {},
+                                             WorkStealingPool &pool = WorkStealingPool::instance());
+
+    void run(WorkStealingPool::Task task);
+    void cancel();
+    [[nodiscard]] bool isCanceled() const;
+
+private:
+    TaskGroup(std::function<void()> onFinished, std::shared_ptr<WorkStealingPool::BulkClient> client, WorkStealingPool &pool);
+
+    WorkStealingPool &m_pool;
+    // Only set for bulk groups.
+    const std::shared_ptr<WorkStealingPool::BulkClient> m_client;
+    const std::function<void()> m_onFinished;
+    std::atomic<size_t> m_outstanding = 0;
+    std::atomic_bool m_canceled = false;
+};
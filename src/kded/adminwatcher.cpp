@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+// SPDX-FileCopyrightText: 2026 Harald Sitter <sitter@kde.org>
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusServiceWatcher>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QUrl>
+
+#include <KDEDModule>
+#include <KDirNotify>
+#include <KPluginFactory>
+
+#include "../kioadmin_debug.h"
+
+/**
+ * Relays changes of admin:/ directories to KDirNotify, so views update without the user having to reload them.
+ *
+ * Listers announce the directories they show through KDirNotify::enteredDirectory. We can't have the helper watch
+ * them on our own though, that would need an authorization only the worker has. Instead the worker asks us after every
+ * listing whether we want to hear about the directory (subscriberFor()) and has the helper send the changes our way.
+ */
+class AdminWatcher : public KDEDModule
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kio.admin.Watcher")
+public:
+    AdminWatcher(QObject *parent, const QVariantList &args)
+        : KDEDModule(parent)
+    {
+        Q_UNUSED(args);
+
+        auto notify = new OrgKdeKDirNotifyInterface(QString(), QString(), QDBusConnection::sessionBus(), this);
+        connect(notify, &OrgKdeKDirNotifyInterface::enteredDirectory, this, &AdminWatcher::enteredDirectory);
+        connect(notify, &OrgKdeKDirNotifyInterface::leftDirectory, this, &AdminWatcher::leftDirectory);
+
+        auto bus = QDBusConnection::systemBus();
+        bus.connect(serviceName(),
+                    QString(),
+                    QStringLiteral("org.kde.kio.admin.WatchCommand"),
+                    QStringLiteral("changes"),
+                    this,
+                    SLOT(changes(QString, QStringList, QStringList, QStringList)));
+        bus.connect(serviceName(), QString(), QStringLiteral("org.kde.kio.admin.WatchCommand"), QStringLiteral("rescan"), this, SLOT(rescan(QString)));
+        bus.connect(serviceName(), QString(), QStringLiteral("org.kde.kio.admin.WatchCommand"), QStringLiteral("removed"), this, SLOT(removed(QString)));
+
+        // Watches don't survive the helper.
+        auto helperWatcher = new QDBusServiceWatcher(serviceName(), bus, QDBusServiceWatcher::WatchForOwnerChange, this);
+        connect(helperWatcher, &QDBusServiceWatcher::serviceOwnerChanged, this, [this] {
+            m_watched.clear();
+        });
+    }
+
+    static QString serviceName()
+    {
+        return QStringLiteral("org.kde.kio.admin");
+    }
+
+public Q_SLOTS:
+    /**
+     * @returns the system bus name the helper should send changes of \a url to. Empty when nobody is looking at
+     * the directory or it is watched already. The worker reports back through watchFailed() if the helper refused.
+     */
+    Q_SCRIPTABLE QString subscriberFor(const QString &url)
+    {
+        const auto key = normalized(url);
+        if (!m_entered.contains(key) || m_watched.contains(key)) {
+            return {};
+        }
+        m_watched.insert(key);
+        return QDBusConnection::systemBus().baseService();
+    }
+
+    /** The worker couldn't have the helper watch \a url after subscriberFor() said so. It may try again next time. */
+    Q_SCRIPTABLE void watchFailed(const QString &url)
+    {
+        m_watched.remove(normalized(url));
+    }
+
+private Q_SLOTS:
+    void enteredDirectory(const QString &url)
+    {
+        if (QUrl(url).scheme() == QLatin1String("admin")) {
+            ++m_entered[normalized(url)];
+        }
+    }
+
+    void leftDirectory(const QString &url)
+    {
+        const auto key = normalized(url);
+        auto it = m_entered.find(key);
+        if (it == m_entered.end() || --it.value() > 0) {
+            return;
+        }
+        m_entered.erase(it);
+        if (m_watched.remove(key)) {
+            unwatch(key);
+        }
+    }
+
+    void changes(const QString &url, const QStringList &created, const QStringList &modified, const QStringList &deleted)
+    {
+        qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO << url << created.size() << modified.size() << deleted;
+        const auto key = normalized(url);
+        if (!m_watched.contains(key)) {
+            unwatch(key);
+            return;
+        }
+
+        // KDirNotify has no way to announce individual new files. Listers list the directory again for those, changed
+        // and removed ones they handle one by one.
+        const QUrl directory(key);
+        if (!created.isEmpty()) {
+            org::kde::KDirNotify::emitFilesAdded(directory);
+        }
+        if (!modified.isEmpty()) {
+            QList<QUrl> urls;
+            for (const auto &name : modified) {
+                urls << childUrl(directory, name);
+            }
+            org::kde::KDirNotify::emitFilesChanged(urls);
+        }
+        if (!deleted.isEmpty()) {
+            QList<QUrl> urls;
+            for (const auto &name : deleted) {
+                urls << childUrl(directory, name);
+            }
+            org::kde::KDirNotify::emitFilesRemoved(urls);
+        }
+    }
+
+    void rescan(const QString &url)
+    {
+        const auto key = normalized(url);
+        if (m_watched.contains(key)) {
+            org::kde::KDirNotify::emitFilesAdded(QUrl(key));
+        }
+    }
+
+    void removed(const QString &url)
+    {
+        const auto key = normalized(url);
+        if (m_watched.remove(key)) {
+            org::kde::KDirNotify::emitFilesRemoved({QUrl(key)});
+        }
+    }
+
+private:
+    static QString normalized(const QString &url)
+    {
+        return QUrl(url).adjusted(QUrl::StripTrailingSlash).toString();
+    }
+
+    static QUrl childUrl(const QUrl &directory, const QString &name)
+    {
+        auto url = directory;
+        auto path = directory.path();
+        if (!path.endsWith(QLatin1Char('/'))) {
+            path += QLatin1Char('/');
+        }
+        url.setPath(path + name);
+        return url;
+    }
+
+    static void unwatch(const QString &url)
+    {
+        auto message = QDBusMessage::createMethodCall(serviceName(), QStringLiteral("/"), QStringLiteral("org.kde.kio.admin"), QStringLiteral("unwatch"));
+        message.setAutoStartService(false);
+        message << url;
+        QDBusConnection::systemBus().send(message);
+    }
+
+    // Listers currently showing a directory, per normalized URL.
+    QHash<QString, int> m_entered;
+    // Directories the helper sends us changes of, or was asked to.
+    QSet<QString> m_watched;
+};
+
+K_PLUGIN_CLASS_WITH_JSON(AdminWatcher, "adminwatcher.json")
+
+#include "adminwatcher.moc"
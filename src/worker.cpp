@@ -1,30 +1,45 @@
 // SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 // SPDX-FileCopyrightText: 2022 Harald Sitter <sitter@kde.org>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstring>
+#include <functional>
 #include <optional>
+#include <utility>
 
 #include <QDBusConnection>
 #include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
 #include <QDBusPendingReply>
+#include <QDateTime>
+#include <QHash>
+#include <QThread>
 #include <polkitqt1-agent-session.h>
 #include <polkitqt1-authority.h>
 
+#include <KDirNotify>
 #include <KIO/WorkerBase>
 #include <KIO/WorkerFactory>
+#include <KLocalizedString>
 
 #include "dbustypes.h"
+#include "interface_batchcommand.h"
+#include "interface_checksumcommand.h"
 #include "interface_chmodcommand.h"
 #include "interface_chowncommand.h"
 #include "interface_copycommand.h"
 #include "interface_delcommand.h"
 #include "interface_file.h"
+#include "interface_findcommand.h"
 #include "interface_getcommand.h"
+#include "interface_grepcommand.h"
 #include "interface_listdircommand.h"
 #include "interface_mkdircommand.h"
 #include "interface_putcommand.h"
 #include "interface_renamecommand.h"
+#include "interface_sizecommand.h"
 #include "interface_statcommand.h"
 #include "kioadmin_debug.h"
 
@@ -34,6 +49,27 @@ using namespace std::chrono_literals;
 namespace
 {
 constexpr auto killPollInterval = 200ms;
+// The kded module answers from memory. Should it hang, views merely don't update live.
+constexpr auto watchQueryTimeout = 500ms;
+// Setting up the watch is cheap, unless the helper is busy.
+constexpr auto watchRequestTimeout = 2s;
+// Zero runs shorter than a filesystem block can't be left as holes anyway, they may as well travel as data.
+constexpr qsizetype minimumHoleSize = 4096;
+// How many zeros go into one data() when a hole of a sparse file has to be spelled out for the client.
+constexpr qsizetype zeroChunkSize = 1024 * 1024;
+// Recent listings answer reloads after the helper confirmed the directory is unchanged. Changes to the entries
+// themselves don't show in the directory's times, so they aren't kept for long.
+constexpr auto listingCacheLifetime = 10s;
+constexpr qsizetype maximumCachedListings = 8;
+constexpr qsizetype maximumCachedListingSize = 20000;
+// Stats of what was just listed, or just found missing, are answered from memory for this long.
+constexpr auto statCacheLifetime = 2s;
+constexpr qsizetype maximumMissingStats = 64;
+
+bool isAllZeros(const QByteArray &data)
+{
+    return !data.isEmpty() && data.front() == '\0' && memcmp(data.constData(), data.constData() + 1, data.size() - 1) == 0;
+}
 
 /**
  * After a user made a choice we want to act accordingly. However, the user might change their
@@ -124,12 +160,106 @@ private:
     std::optional<Result> m_result;
 };
 
+/**
+ * Offers watches to the helper without holding up the listing that prompted them. The worker's thread only runs an
+ * event loop while it waits for the helper, the replies are handled on a thread of our own instead.
+ */
+class WatchOffers : public QObject
+{
+public:
+    static WatchOffers &instance()
+    {
+        // Never destroyed, the thread lives as long as the worker process.
+        static auto offers = [] {
+            auto thread = new QThread;
+            thread->setObjectName(QStringLiteral("WatchOffers"));
+            thread->start();
+            auto offers = new WatchOffers;
+            offers->moveToThread(thread);
+            return offers;
+        }();
+        return *offers;
+    }
+
+    /** Asks the kded module whether a view shows \a stringUrl, if so sends \a watchRequest along with the subscriber. */
+    void offer(const QString &stringUrl, const QDBusMessage &watchRequest)
+    {
+        QMetaObject::invokeMethod(this, [this, stringUrl, watchRequest] {
+            auto query = watcherCall(QStringLiteral("subscriberFor"), stringUrl);
+            auto pending = QDBusConnection::sessionBus().asyncCall(query, int(std::chrono::milliseconds(watchQueryTimeout).count()));
+            onFinished(pending, [this, stringUrl, watchRequest](const QDBusMessage &reply) {
+                if (reply.type() != QDBusMessage::ReplyMessage || reply.arguments().isEmpty()) {
+                    return;
+                }
+                const auto subscriber = reply.arguments().at(0).toString();
+                if (!subscriber.isEmpty()) {
+                    watch(stringUrl, subscriber, watchRequest);
+                }
+            });
+        });
+    }
+
+private:
+    WatchOffers() = default;
+
+    static QDBusMessage watcherCall(const QString &method, const QString &stringUrl)
+    {
+        auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.kded6"),
+                                                      QStringLiteral("/modules/kioadminwatcher"),
+                                                      QStringLiteral("org.kde.kio.admin.Watcher"),
+                                                      method);
+        message.setAutoStartService(false);
+        message << stringUrl;
+        return message;
+    }
+
+    void onFinished(const QDBusPendingCall &pending, const std::function<void(const QDBusMessage &reply)> &callback)
+    {
+        auto watcher = new QDBusPendingCallWatcher(pending, this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [callback](QDBusPendingCallWatcher *watcher) {
+            watcher->deleteLater();
+            callback(watcher->reply());
+        });
+    }
+
+    void watch(const QString &stringUrl, const QString &subscriber, QDBusMessage request)
+    {
+        request << stringUrl << subscriber;
+        auto pending = QDBusConnection::systemBus().asyncCall(request, int(std::chrono::milliseconds(watchRequestTimeout).count()));
+        onFinished(pending, [stringUrl](const QDBusMessage &reply) {
+            if (reply.type() == QDBusMessage::ReplyMessage) {
+                return;
+            }
+            // Otherwise the module would consider the directory watched and never offer it again.
+            qCDebug(KIOADMIN_LOG) << "Failed to watch" << stringUrl << reply.errorName() << reply.errorMessage();
+            QDBusConnection::sessionBus().send(watcherCall(QStringLiteral("watchFailed"), stringUrl));
+        });
+    }
+};
+
 class AdminWorker : public QObject, public WorkerBase
 {
     Q_OBJECT
 public:
     using WorkerBase::WorkerBase;
 
+    /** A complete listing along with the validator the helper sent for it. */
+    struct CachedListing {
+        QString url;
+        int details = 0;
+        qulonglong device = 0;
+        qulonglong inode = 0;
+        qlonglong modificationTime = 0;
+        qlonglong changeTime = 0;
+        KIO::UDSEntryList entries;
+        std::chrono::steady_clock::time_point listedAt;
+    };
+
+    struct Missing {
+        std::chrono::steady_clock::time_point missingSince;
+        QString errorString;
+    };
+
     static QString serviceName()
     {
         return QStringLiteral("org.kde.kio.admin");
@@ -146,7 +276,8 @@ public:
     }
 
     // Start the eventloop but check every couple milliseconds if the worker was
-    // aborted, if that is the case quit the loop.
+    // aborted, if that is the case quit the loop. Deadlines don't apply, the
+    // operations waited for here can't be stopped halfway.
     void execLoop(QEventLoop &loop)
     {
         QTimer timer;
@@ -175,7 +306,7 @@ public:
             &QTimer::timeout,
             &timer,
             [this, &loop, &iface] {
-                if (wasKilled()) {
+                if (wasKilled() || expire()) {
                     iface.kill();
                     loop.quit();
                 }
@@ -185,6 +316,36 @@ public:
         loop.exec();
     }
 
+    /** @returns the point in time (ms since the epoch) after which the client no longer wants the result, if it set one. */
+    [[nodiscard]] std::optional<qint64> deadline() const
+    {
+        bool ok = false;
+        const auto deadline = metaData(QStringLiteral("deadline")).toLongLong(&ok);
+        return ok ? std::optional(deadline) : std::nullopt;
+    }
+
+    // The helper drops the command on its own once the deadline passed, whether it got started yet or not. Fire and
+    // forget, calls are delivered in order so it arrives before start().
+    void forwardDeadline(const QString &path)
+    {
+        if (const auto deadline = this->deadline()) {
+            auto message = QDBusMessage::createMethodCall(serviceName(), path, QStringLiteral("org.kde.kio.admin.Command"), QStringLiteral("setDeadline"));
+            message << *deadline;
+            QDBusConnection::systemBus().send(message);
+        }
+    }
+
+    /** Fails the current request once its deadline passed. @returns whether it did. */
+    bool expire()
+    {
+        const auto deadline = this->deadline();
+        if (!deadline || QDateTime::currentMSecsSinceEpoch() < *deadline) {
+            return false;
+        }
+        m_result = WorkerResult::fail(ERR_SERVER_TIMEOUT, serviceName());
+        return true;
+    }
+
     [[nodiscard]] WorkerResult toFailure(const QDBusMessage &msg)
     {
         qWarning() << msg.errorName() << msg.errorMessage();
@@ -197,6 +358,25 @@ public:
         return WorkerResult::fail();
     }
 
+    /** @returns the stat details the client asked for. Only those get determined by the helper. */
+    [[nodiscard]] int statDetails() const
+    {
+        if (hasMetaData(QStringLiteral("statDetails"))) {
+            return metaData(QStringLiteral("statDetails")).toInt();
+        }
+        return KIO::StatDefaultDetails;
+    }
+
+    /**
+     * Has the helper send changes of \a url to the kded module, if a view is showing the directory. The module can't
+     * set up the watch itself, it isn't authorized.
+     */
+    void offerWatch(const QUrl &url)
+    {
+        auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("watch"));
+        WatchOffers::instance().offer(url.adjusted(QUrl::StripTrailingSlash).toString(), request);
+    }
+
     /** @returns true if \a request is considered more important than what was remembered previously. false otherwise. */
     bool considerRemembering(ReadAuthorizationRequest request)
     {
@@ -278,6 +458,99 @@ public:
         return std::nullopt;
     }
 
+    /** @returns the listing of \a url with \a details from not long ago, if there is one. */
+    [[nodiscard]] const CachedListing *cachedListing(const QString &url, int details)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        m_listings.removeIf([now](const CachedListing &listing) {
+            return now - listing.listedAt > listingCacheLifetime;
+        });
+        const auto it = std::find_if(m_listings.cbegin(), m_listings.cend(), [&url, details](const CachedListing &listing) {
+            return listing.url == url && listing.details == details;
+        });
+        return it == m_listings.cend() ? nullptr : &*it;
+    }
+
+    void forgetListing(const QString &url, int details)
+    {
+        m_listings.removeIf([&url, details](const CachedListing &listing) {
+            return listing.url == url && listing.details == details;
+        });
+    }
+
+    /** Keeps \a entries of a finished listing, with the sniffed mimetypes folded in. */
+    void cacheListing(CachedListing listing, KIO::UDSEntryList entries, const QHash<QString, QString> &sniffedMimeTypes)
+    {
+        for (auto &entry : entries) {
+            // A mount point that didn't answer may well answer next time.
+            if (entry.contains(UDS_ADMIN_INCOMPLETE)) {
+                return;
+            }
+            if (const auto it = sniffedMimeTypes.constFind(entry.stringValue(KIO::UDSEntry::UDS_NAME)); it != sniffedMimeTypes.cend()) {
+                entry.replace(KIO::UDSEntry::UDS_MIME_TYPE, it.value());
+            }
+        }
+        listing.entries = std::move(entries);
+        listing.listedAt = std::chrono::steady_clock::now();
+        m_listings.prepend(std::move(listing));
+        while (m_listings.size() > maximumCachedListings) {
+            m_listings.removeLast();
+        }
+    }
+
+    /** Something was changed through us, what we remember of the filesystem may no longer be true. */
+    void forgetCachedState()
+    {
+        m_listings.clear();
+        m_statDirectory.clear();
+        m_statEntries.clear();
+        m_missing.clear();
+    }
+
+    /** @returns the result of a stat of \a url that can be told without asking the helper, if there is one. */
+    [[nodiscard]] std::optional<WorkerResult> cachedStat(const QUrl &url)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const auto stripped = url.adjusted(QUrl::StripTrailingSlash);
+        if (const auto it = m_missing.constFind(stripped.toString()); it != m_missing.cend()) {
+            if (now - it->missingSince < statCacheLifetime) {
+                return WorkerResult::fail(ERR_DOES_NOT_EXIST, it->errorString);
+            }
+            m_missing.erase(it);
+        }
+
+        if (m_statDirectory.isEmpty() || now - m_statEntriesAt >= statCacheLifetime) {
+            m_statDirectory.clear();
+            m_statEntries.clear();
+            return std::nullopt;
+        }
+        const auto details = statDetails();
+        if ((details & ~m_statDetails) != 0 || stripped.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash).toString() != m_statDirectory) {
+            return std::nullopt;
+        }
+        const auto it = m_statEntries.constFind(stripped.fileName());
+        // Listings only guess most mimetypes.
+        if (it == m_statEntries.cend() || ((details & KIO::StatMimeType) && !it->contains(KIO::UDSEntry::UDS_MIME_TYPE))) {
+            return std::nullopt;
+        }
+        statEntry(it.value());
+        return WorkerResult::pass();
+    }
+
+    void rememberMissing(const QUrl &url, const QString &errorString)
+    {
+        if (m_missing.size() >= maximumMissingStats) {
+            const auto now = std::chrono::steady_clock::now();
+            m_missing.removeIf([now](const QHash<QString, Missing>::iterator &it) {
+                return now - it->missingSince >= statCacheLifetime;
+            });
+            if (m_missing.size() >= maximumMissingStats) {
+                m_missing.clear();
+            }
+        }
+        m_missing.insert(url.adjusted(QUrl::StripTrailingSlash).toString(), {std::chrono::steady_clock::now(), errorString});
+    }
+
     WorkerResult listDir(const QUrl &url) override
     {
         ReadAuthorizationRequest thisRequest;
@@ -286,8 +559,18 @@ public:
             return WorkerResult::fail();
         }
 
-        auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("listDir"));
-        request << url.toString();
+        // Clients may page through huge directories by setting listCursor, listLimit and/or listNameFilter metadata.
+        // listNextCursor is set on the job while there is more to list.
+        const bool ranged = hasMetaData(QStringLiteral("listCursor")) || hasMetaData(QStringLiteral("listLimit"))
+            || hasMetaData(QStringLiteral("listNameFilter"));
+        const auto method = ranged ? QStringLiteral("listDirRange") : QStringLiteral("listDir");
+        auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), method);
+        request << url.toString() << statDetails();
+        if (ranged) {
+            const auto limit = metaData(QStringLiteral("listLimit"));
+            request << metaData(QStringLiteral("listCursor")).toLongLong() << (limit.isEmpty() ? -1 : limit.toInt())
+                    << metaData(QStringLiteral("listNameFilter"));
+        }
         auto reply = QDBusConnection::systemBus().call(request);
         thisRequest.setResult(reply);
 
@@ -298,18 +581,57 @@ public:
         }
 
         const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
         qCDebug(KIOADMIN_LOG) << path;
 
         OrgKdeKioAdminListDirCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
         connect(&iface, &OrgKdeKioAdminListDirCommandInterface::result, this, &AdminWorker::result);
 
+        // Recent complete listings are revalidated by the helper and sent again from here when nothing changed.
+        const auto cacheUrl = url.adjusted(QUrl::StripTrailingSlash).toString();
+        const auto cached = ranged ? nullptr : cachedListing(cacheUrl, statDetails());
+        if (cached) {
+            iface.setValidator(cached->device, cached->inode, cached->modificationTime, cached->changeTime);
+        }
+        std::optional<CachedListing> validated;
+        bool notModified = false;
+        connect(&iface,
+                &OrgKdeKioAdminListDirCommandInterface::validator,
+                this,
+                [this, &validated, &cacheUrl](qulonglong device, qulonglong inode, qlonglong modificationTime, qlonglong changeTime) {
+                    validated = CachedListing{cacheUrl, statDetails(), device, inode, modificationTime, changeTime, {}, {}};
+                });
+        connect(&iface, &OrgKdeKioAdminListDirCommandInterface::notModified, this, [&notModified] {
+            notModified = true;
+        });
+        if (!ranged) {
+            m_collectedEntries = KIO::UDSEntryList();
+        }
+        // Jobs tend to stat what they just listed. The entries answer them for a moment, see cachedStat().
+        m_statDirectory = cacheUrl;
+        m_statDetails = statDetails();
+        m_statEntries.clear();
+        m_statEntriesAt = std::chrono::steady_clock::now();
+
         QDBusConnection::systemBus().connect(serviceName(),
                                              path,
                                              QStringLiteral("org.kde.kio.admin.ListDirCommand"),
                                              QStringLiteral("entries"),
                                              this,
                                              SLOT(entries(KIO::UDSEntryList)));
+        QDBusConnection::systemBus().connect(serviceName(),
+                                             path,
+                                             QStringLiteral("org.kde.kio.admin.ListDirCommand"),
+                                             QStringLiteral("mimeTypes"),
+                                             this,
+                                             SLOT(mimeTypes(QStringList, QStringList)));
+        connect(&iface, &OrgKdeKioAdminListDirCommandInterface::pageEnd, this, [this](qlonglong cursor, bool atEnd) {
+            if (!atEnd) {
+                setMetaData(QStringLiteral("listNextCursor"), QString::number(cursor));
+            }
+        });
 
+        m_listingUrl = url;
         iface.start();
 
         execLoopWithTerminatingIface(loop, iface);
@@ -320,11 +642,45 @@ public:
                                                 QStringLiteral("entries"),
                                                 this,
                                                 SLOT(entries(KIO::UDSEntryList)));
+        QDBusConnection::systemBus().disconnect(serviceName(),
+                                                path,
+                                                QStringLiteral("org.kde.kio.admin.ListDirCommand"),
+                                                QStringLiteral("mimeTypes"),
+                                                this,
+                                                SLOT(mimeTypes(QStringList, QStringList)));
+        auto collectedEntries = std::exchange(m_collectedEntries, std::nullopt);
+        const auto sniffedMimeTypes = std::exchange(m_sniffedMimeTypes, {});
+        if (!m_result.success()) {
+            m_statDirectory.clear();
+        }
+        if (m_result.success() && notModified && cached) {
+            qCDebug(KIOADMIN_LOG) << "Listing of" << url << "is unchanged";
+            // The entries themselves may have changed since, they are no answer to stats.
+            m_statDirectory.clear();
+            entries(cached->entries);
+        } else if (!ranged) {
+            forgetListing(cacheUrl, statDetails());
+            if (m_result.success() && validated && collectedEntries) {
+                cacheListing(std::move(*validated), std::move(*collectedEntries), sniffedMimeTypes);
+            }
+        }
+        // Entries can't be amended once listed. Have listers refresh the ones whose mimetype turned out to be different,
+        // the helper remembers what it sniffed and provides it right away this time around.
+        if (!m_refinedUrls.isEmpty()) {
+            org::kde::KDirNotify::emitFilesChanged(std::exchange(m_refinedUrls, {}));
+        }
+        // Only complete listings are worth keeping up to date.
+        if (!ranged && m_result.success()) {
+            offerWatch(url);
+        }
         return m_result;
     }
 
     WorkerResult open(const QUrl &url, QIODevice::OpenMode mode) override
     {
+        if (mode & (QIODevice::WriteOnly | QIODevice::Append | QIODevice::Truncate)) {
+            forgetCachedState();
+        }
         qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
         auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("file"));
         request << url.toString() << (int)mode;
@@ -384,6 +740,7 @@ public:
 
     WorkerResult write(const QByteArray &data) override
     {
+        forgetCachedState();
         qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
         Q_ASSERT(!m_pendingWrite.has_value());
         m_pendingWrite = data.size();
@@ -402,6 +759,7 @@ public:
 
     WorkerResult truncate(KIO::filesize_t size) override
     {
+        forgetCachedState();
         qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
         m_file->truncate(size);
         execLoop(loop);
@@ -418,6 +776,7 @@ public:
 
     WorkerResult put(const QUrl &url, int permissions, JobFlags flags) override
     {
+        forgetCachedState();
         auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("put"));
         request << url.toString() << permissions << static_cast<int>(flags);
         auto reply = QDBusConnection::systemBus().call(request);
@@ -425,6 +784,7 @@ public:
             return toFailure(reply);
         }
         const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
 
         OrgKdeKioAdminPutCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
 
@@ -434,9 +794,38 @@ public:
             if (const int read = readData(buffer); read < 0) {
                 qWarning() << "Failed to read data for unknown reason" << read;
             }
+            if (buffer.size() >= minimumHoleSize && isAllZeros(buffer)) {
+                iface.hole(buffer.size());
+                return;
+            }
             iface.data(buffer);
         });
         connect(&iface, &OrgKdeKioAdminPutCommandInterface::result, this, &AdminWorker::result);
+        if (const auto durability = metaData(QStringLiteral("durability")); !durability.isEmpty()) {
+            // none, file, directory or group. See PutCommand::setDurability.
+            QDBusPendingReply<> durabilityReply = iface.setDurability(durability);
+            durabilityReply.waitForFinished();
+            if (durabilityReply.isError()) {
+                if (durabilityReply.error().type() == QDBusError::NotSupported) {
+                    return WorkerResult::fail(ERR_UNSUPPORTED_ACTION, durability);
+                }
+                return toFailure(durabilityReply.reply());
+            }
+        }
+        if (const auto algorithm = metaData(QStringLiteral("checksum")); !algorithm.isEmpty()) {
+            // The helper hashes what it writes, sparing clients to read the file back for verification.
+            QDBusPendingReply<> checksumReply = iface.setChecksumAlgorithm(algorithm);
+            checksumReply.waitForFinished();
+            if (checksumReply.isError()) {
+                if (checksumReply.error().type() == QDBusError::NotSupported) {
+                    return WorkerResult::fail(ERR_UNSUPPORTED_ACTION, algorithm);
+                }
+                return toFailure(checksumReply.reply());
+            }
+            connect(&iface, &OrgKdeKioAdminPutCommandInterface::checksum, this, [this](const QString &digest) {
+                setMetaData(QStringLiteral("checksum"), digest);
+            });
+        }
         iface.start();
 
         execLoopWithTerminatingIface(loop, iface);
@@ -445,6 +834,10 @@ public:
 
     WorkerResult stat(const QUrl &url) override
     {
+        if (auto result = cachedStat(url)) {
+            return std::move(*result);
+        }
+
         ReadAuthorizationRequest thisRequest;
         const auto resultOfPreviousSimilarRequest = resultOfPreviousRequestSimilarTo(thisRequest);
         if (resultOfPreviousSimilarRequest && resultOfPreviousSimilarRequest == ReadAuthorizationRequest::Result::Denied) {
@@ -452,7 +845,7 @@ public:
         }
 
         auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("stat"));
-        request << url.toString();
+        request << url.toString() << statDetails();
         auto reply = QDBusConnection::systemBus().call(request);
         thisRequest.setResult(reply);
 
@@ -462,6 +855,7 @@ public:
             return toFailure(reply);
         }
         const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
 
         QDBusConnection::systemBus()
             .connect(serviceName(), path, QStringLiteral("org.kde.kio.admin.StatCommand"), QStringLiteral("statEntry"), this, SLOT(entry(KIO::UDSEntry)));
@@ -473,17 +867,27 @@ public:
         QDBusConnection::systemBus().call(
             QDBusMessage::createMethodCall(serviceName(), path, QStringLiteral("org.kde.kio.admin.StatCommand"), QStringLiteral("start")));
 
-        execLoop(loop);
+        execLoopWithTerminatingIface(loop, iface);
 
         QDBusConnection::systemBus()
             .disconnect(serviceName(), path, QStringLiteral("org.kde.kio.admin.StatCommand"), QStringLiteral("statEntry"), this, SLOT(entry(KIO::UDSEntry)));
 
+        if (m_result.error() == ERR_DOES_NOT_EXIST) {
+            rememberMissing(url, m_result.errorString());
+        }
         return m_result;
     }
 
     WorkerResult copy(const QUrl &src, const QUrl &dest, int permissions, JobFlags flags) override
     {
         qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
+        return copyCommand(src, dest, permissions, flags);
+    }
+
+    /** Files are copied by KIO::copy in the helper, local directories natively as a whole. */
+    WorkerResult copyCommand(const QUrl &src, const QUrl &dest, int permissions, JobFlags flags)
+    {
+        forgetCachedState();
         auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("copy"));
         request << src.toString() << dest.toString() << permissions << static_cast<int>(flags);
         auto reply = QDBusConnection::systemBus().call(request);
@@ -491,13 +895,17 @@ public:
             return toFailure(reply);
         }
         const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
         qCDebug(KIOADMIN_LOG) << path;
 
         OrgKdeKioAdminCopyCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
+        connect(&iface, &OrgKdeKioAdminCopyCommandInterface::processedSize, this, [this](qulonglong bytes) {
+            processedSize(bytes);
+        });
         connect(&iface, &OrgKdeKioAdminCopyCommandInterface::result, this, &AdminWorker::result);
         iface.start();
 
-        execLoop(loop);
+        execLoopWithTerminatingIface(loop, iface);
         return m_result;
     }
 
@@ -511,12 +919,27 @@ public:
             return toFailure(reply);
         }
         const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
         qCDebug(KIOADMIN_LOG) << path;
 
         OrgKdeKioAdminGetCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
         connect(&iface, &OrgKdeKioAdminGetCommandInterface::data, this, [this](const QByteArray &blob) {
             data(blob);
         });
+        connect(&iface, &OrgKdeKioAdminGetCommandInterface::hole, this, [this](qulonglong length) {
+            // Clients have no notion of holes. At least the zeros didn't cross the system bus.
+            static const QByteArray zeros(zeroChunkSize, '\0');
+            for (; length >= qulonglong(zeros.size()); length -= zeros.size()) {
+                // A hole may be large, don't make a client that gave up wait for all of it.
+                if (wasKilled() || expire()) {
+                    return;
+                }
+                data(zeros);
+            }
+            if (length > 0) {
+                data(zeros.left(qsizetype(length)));
+            }
+        });
         connect(&iface, &OrgKdeKioAdminGetCommandInterface::mimeTypeFound, this, [this](const QString &mimetype) {
             mimeType(mimetype);
         });
@@ -529,6 +952,7 @@ public:
 
     WorkerResult del(const QUrl &url, bool isFile) override
     {
+        forgetCachedState();
         Q_UNUSED(isFile);
 
         qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
@@ -539,18 +963,27 @@ public:
             return toFailure(reply);
         }
         const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
 
         OrgKdeKioAdminDelCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
+        connect(&iface, &OrgKdeKioAdminDelCommandInterface::processedItems, this, [this](qulonglong items) {
+            infoMessage(i18ncp("@info:progress", "Deleted %1 item", "Deleted %1 items", items));
+        });
         connect(&iface, &OrgKdeKioAdminDelCommandInterface::result, this, &AdminWorker::result);
         iface.start();
 
-        execLoop(loop);
+        execLoopWithTerminatingIface(loop, iface);
         return m_result;
     }
 
     WorkerResult mkdir(const QUrl &url, int permissions) override
     {
+        forgetCachedState();
         qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
+        // Not started at all once the deadline passed, the helper couldn't stop it halfway.
+        if (expire()) {
+            return m_result;
+        }
         auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("mkdir"));
         request << url.toString() << permissions;
         auto reply = QDBusConnection::systemBus().call(request);
@@ -569,7 +1002,11 @@ public:
 
     WorkerResult rename(const QUrl &src, const QUrl &dest, JobFlags flags) override
     {
+        forgetCachedState();
         qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
+        if (expire()) {
+            return m_result;
+        }
         auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("rename"));
         request << src.toString() << dest.toString() << static_cast<int>(flags);
         auto reply = QDBusConnection::systemBus().call(request);
@@ -586,11 +1023,38 @@ public:
         return m_result;
     }
 
+    // Atomically swaps two existing local paths, e.g. a config file and its replacement.
+    WorkerResult exchange(const QUrl &src, const QUrl &dest)
+    {
+        qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
+        if (expire()) {
+            return m_result;
+        }
+        auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("exchange"));
+        request << src.toString() << dest.toString();
+        auto reply = QDBusConnection::systemBus().call(request);
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            return toFailure(reply);
+        }
+        const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+
+        OrgKdeKioAdminRenameCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
+        connect(&iface, &OrgKdeKioAdminRenameCommandInterface::result, this, &AdminWorker::result);
+        iface.start();
+
+        execLoop(loop);
+        return m_result;
+    }
+
     //  WorkerResult symlink(const QString &target, const QUrl &dest, JobFlags flags) override;
 
     WorkerResult chmod(const QUrl &url, int permissions) override
     {
+        forgetCachedState();
         qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
+        if (expire()) {
+            return m_result;
+        }
         auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("chmod"));
         request << url.toString() << permissions;
         auto reply = QDBusConnection::systemBus().call(request);
@@ -609,7 +1073,11 @@ public:
 
     WorkerResult chown(const QUrl &url, const QString &owner, const QString &group) override
     {
+        forgetCachedState();
         qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
+        if (expire()) {
+            return m_result;
+        }
         auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("chown"));
         request << url.toString() << owner << group;
         auto reply = QDBusConnection::systemBus().call(request);
@@ -626,6 +1094,230 @@ public:
         return m_result;
     }
 
+    WorkerResult chmodTree(const QUrl &url, int permissions, int fileMask, int directoryMask, bool recursive)
+    {
+        qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
+        auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("chmodTree"));
+        request << url.toString() << permissions << fileMask << directoryMask << recursive;
+        auto reply = QDBusConnection::systemBus().call(request);
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            return toFailure(reply);
+        }
+        const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
+
+        OrgKdeKioAdminChmodCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
+        connect(&iface, &OrgKdeKioAdminChmodCommandInterface::processedItems, this, [this](qulonglong items) {
+            infoMessage(i18ncp("@info:progress", "Changed permissions of %1 item", "Changed permissions of %1 items", items));
+        });
+        connect(&iface, &OrgKdeKioAdminChmodCommandInterface::failures, this, &AdminWorker::failures);
+        connect(&iface, &OrgKdeKioAdminChmodCommandInterface::result, this, &AdminWorker::result);
+        iface.start();
+
+        execLoopWithTerminatingIface(loop, iface);
+        return m_result;
+    }
+
+    WorkerResult directorySize(const QUrl &url)
+    {
+        qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO << url;
+        auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("directorySize"));
+        request << url.toString();
+        auto reply = QDBusConnection::systemBus().call(request);
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            return toFailure(reply);
+        }
+        const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
+
+        OrgKdeKioAdminSizeCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
+        connect(&iface,
+                &OrgKdeKioAdminSizeCommandInterface::totals,
+                this,
+                [this](qulonglong size, qulonglong allocatedSize, qulonglong files, qulonglong directories) {
+                    processedSize(size);
+                    setMetaData(QStringLiteral("totalSize"), QString::number(size));
+                    setMetaData(QStringLiteral("allocatedSize"), QString::number(allocatedSize));
+                    setMetaData(QStringLiteral("totalFiles"), QString::number(files));
+                    setMetaData(QStringLiteral("totalSubdirs"), QString::number(directories));
+                });
+        connect(&iface, &OrgKdeKioAdminSizeCommandInterface::result, this, &AdminWorker::result);
+        iface.start();
+
+        execLoopWithTerminatingIface(loop, iface);
+        return m_result;
+    }
+
+    WorkerResult checksum(const QUrl &url, const QString &algorithm)
+    {
+        qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO << url << algorithm;
+        auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("checksum"));
+        request << url.toString() << algorithm;
+        auto reply = QDBusConnection::systemBus().call(request);
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            return toFailure(reply);
+        }
+        const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
+
+        OrgKdeKioAdminChecksumCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
+        connect(&iface, &OrgKdeKioAdminChecksumCommandInterface::processedSize, this, [this](qulonglong bytes) {
+            processedSize(bytes);
+        });
+        connect(&iface, &OrgKdeKioAdminChecksumCommandInterface::checksum, this, [this](const QString &digest) {
+            setMetaData(QStringLiteral("checksum"), digest);
+        });
+        connect(&iface, &OrgKdeKioAdminChecksumCommandInterface::result, this, &AdminWorker::result);
+        iface.start();
+
+        execLoopWithTerminatingIface(loop, iface);
+        return m_result;
+    }
+
+    WorkerResult find(const QUrl &url, const QString &namePattern, int type, qlonglong minSize, qlonglong modifiedAfter, qlonglong modifiedBefore)
+    {
+        qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO << url << namePattern;
+        auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("find"));
+        request << url.toString() << namePattern << type << minSize << modifiedAfter << modifiedBefore << statDetails();
+        auto reply = QDBusConnection::systemBus().call(request);
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            return toFailure(reply);
+        }
+        const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
+
+        OrgKdeKioAdminFindCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
+        connect(&iface, &OrgKdeKioAdminFindCommandInterface::result, this, &AdminWorker::result);
+        QDBusConnection::systemBus().connect(serviceName(),
+                                             path,
+                                             QStringLiteral("org.kde.kio.admin.FindCommand"),
+                                             QStringLiteral("entries"),
+                                             this,
+                                             SLOT(foundEntries(KIO::UDSEntryList)));
+        iface.start();
+
+        execLoopWithTerminatingIface(loop, iface);
+
+        QDBusConnection::systemBus().disconnect(serviceName(),
+                                                path,
+                                                QStringLiteral("org.kde.kio.admin.FindCommand"),
+                                                QStringLiteral("entries"),
+                                                this,
+                                                SLOT(foundEntries(KIO::UDSEntryList)));
+        return m_result;
+    }
+
+    WorkerResult grep(const QUrl &url, const QString &fileGlob, const QString &pattern, int flags, int maxResults)
+    {
+        qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO << url << fileGlob << pattern;
+        auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("grep"));
+        request << url.toString() << fileGlob << pattern << flags << maxResults;
+        auto reply = QDBusConnection::systemBus().call(request);
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            return toFailure(reply);
+        }
+        const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
+
+        OrgKdeKioAdminGrepCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
+        connect(&iface,
+                &OrgKdeKioAdminGrepCommandInterface::matches,
+                this,
+                [this, &url](const QStringList &paths, const QList<qulonglong> &lineNumbers, const QStringList &lines) {
+                    QByteArray buffer;
+                    QDataStream stream(&buffer, QIODevice::WriteOnly);
+                    for (qsizetype i = 0; i < paths.size() && i < lineNumbers.size() && i < lines.size(); ++i) {
+                        auto fileUrl = url;
+                        fileUrl.setPath(paths.at(i));
+                        stream << fileUrl << lineNumbers.at(i) << lines.at(i);
+                    }
+                    data(buffer);
+                });
+        connect(&iface, &OrgKdeKioAdminGrepCommandInterface::result, this, &AdminWorker::result);
+        iface.start();
+
+        execLoopWithTerminatingIface(loop, iface);
+        return m_result;
+    }
+
+    // Runs one helper-side batch for a whole selection. KIO itself dispatches per URL, clients get here through special().
+    WorkerResult batch(const QString &method,
+                       const QList<QUrl> &urls,
+                       const QVariantList &arguments,
+                       const std::function<QString(qulonglong)> &progressMessage = {})
+    {
+        qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO << method << urls.size();
+        QStringList stringUrls;
+        stringUrls.reserve(urls.size());
+        for (const auto &url : urls) {
+            stringUrls << url.toString();
+        }
+        auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), method);
+        request << stringUrls;
+        for (const auto &argument : arguments) {
+            request << argument;
+        }
+        auto reply = QDBusConnection::systemBus().call(request);
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            return toFailure(reply);
+        }
+        const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
+
+        OrgKdeKioAdminBatchCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
+        if (progressMessage) {
+            connect(&iface, &OrgKdeKioAdminBatchCommandInterface::processedItems, this, [this, &progressMessage](qulonglong items) {
+                infoMessage(progressMessage(items));
+            });
+        }
+        connect(&iface, &OrgKdeKioAdminBatchCommandInterface::failures, this, &AdminWorker::failures);
+        connect(&iface, &OrgKdeKioAdminBatchCommandInterface::result, this, &AdminWorker::result);
+        QDBusConnection::systemBus().connect(serviceName(),
+                                             path,
+                                             QStringLiteral("org.kde.kio.admin.BatchCommand"),
+                                             QStringLiteral("statEntries"),
+                                             this,
+                                             SLOT(statEntries(QList<int>, KIO::UDSEntryList)));
+
+        m_batchUrls = urls;
+        iface.start();
+
+        execLoopWithTerminatingIface(loop, iface);
+
+        QDBusConnection::systemBus().disconnect(serviceName(),
+                                                path,
+                                                QStringLiteral("org.kde.kio.admin.BatchCommand"),
+                                                QStringLiteral("statEntries"),
+                                                this,
+                                                SLOT(statEntries(QList<int>, KIO::UDSEntryList)));
+        m_batchUrls.clear();
+        return m_result;
+    }
+
+    WorkerResult chownTree(const QUrl &url, const QString &owner, const QString &group, bool recursive)
+    {
+        qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
+        auto request = QDBusMessage::createMethodCall(serviceName(), servicePath(), serviceInterface(), QStringLiteral("chownTree"));
+        request << url.toString() << owner << group << recursive;
+        auto reply = QDBusConnection::systemBus().call(request);
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            return toFailure(reply);
+        }
+        const auto path = reply.arguments().at(0).value<QDBusObjectPath>().path();
+        forwardDeadline(path);
+
+        OrgKdeKioAdminChownCommandInterface iface(serviceName(), path, QDBusConnection::systemBus(), this);
+        connect(&iface, &OrgKdeKioAdminChownCommandInterface::processedItems, this, [this](qulonglong items) {
+            infoMessage(i18ncp("@info:progress", "Changed ownership of %1 item", "Changed ownership of %1 items", items));
+        });
+        connect(&iface, &OrgKdeKioAdminChownCommandInterface::failures, this, &AdminWorker::failures);
+        connect(&iface, &OrgKdeKioAdminChownCommandInterface::result, this, &AdminWorker::result);
+        iface.start();
+
+        execLoopWithTerminatingIface(loop, iface);
+        return m_result;
+    }
+
     // WorkerResult setModificationTime(const QUrl &url, const QDateTime &mtime) override
     // {
     //     qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
@@ -650,6 +1342,107 @@ public:
             }
             return WorkerResult::pass();
         }
+        case 2: { // Tree chmod: QUrl url, int permissions, int fileMask, int directoryMask, bool recursive
+            forgetCachedState();
+            QUrl url;
+            int permissions = 0;
+            int fileMask = 0;
+            int directoryMask = 0;
+            bool recursive = false;
+            stream >> url >> permissions >> fileMask >> directoryMask >> recursive;
+            return chmodTree(url, permissions, fileMask, directoryMask, recursive);
+        }
+        case 3: { // Tree chown: QUrl url, QString owner, QString group, bool recursive
+            forgetCachedState();
+            QUrl url;
+            QString owner;
+            QString group;
+            bool recursive = false;
+            stream >> url >> owner >> group >> recursive;
+            return chownTree(url, owner, group, recursive);
+        }
+        case 4: { // Exchange: QUrl src, QUrl dest
+            forgetCachedState();
+            QUrl src;
+            QUrl dest;
+            stream >> src >> dest;
+            return exchange(src, dest);
+        }
+        case 5: { // Stat many: QList<QUrl> urls. Replies through data() with a QDataStream of QUrl, KIO::UDSEntry pairs.
+            QList<QUrl> urls;
+            stream >> urls;
+            return batch(QStringLiteral("statMany"), urls, {statDetails()});
+        }
+        case 6: { // Delete many: QList<QUrl> urls
+            forgetCachedState();
+            QList<QUrl> urls;
+            stream >> urls;
+            return batch(QStringLiteral("delMany"), urls, {}, [](qulonglong items) {
+                return i18ncp("@info:progress", "Deleted %1 item", "Deleted %1 items", items);
+            });
+        }
+        case 7: { // Chmod many: QList<QUrl> urls, int permissions
+            forgetCachedState();
+            QList<QUrl> urls;
+            int permissions = 0;
+            stream >> urls >> permissions;
+            return batch(QStringLiteral("chmodMany"), urls, {permissions}, [](qulonglong items) {
+                return i18ncp("@info:progress", "Changed permissions of %1 item", "Changed permissions of %1 items", items);
+            });
+        }
+        case 8: { // Rename many: QList<QUrl> sources, QList<QUrl> destinations, int flags
+            forgetCachedState();
+            QList<QUrl> sources;
+            QList<QUrl> destinations;
+            int flags = 0;
+            stream >> sources >> destinations >> flags;
+            QStringList stringDestinations;
+            for (const auto &url : destinations) {
+                stringDestinations << url.toString();
+            }
+            return batch(QStringLiteral("renameMany"), sources, {stringDestinations, flags}, [](qulonglong items) {
+                return i18ncp("@info:progress", "Renamed %1 item", "Renamed %1 items", items);
+            });
+        }
+        case 9: { // Directory size: QUrl url. Replies with totalSize, allocatedSize, totalFiles and totalSubdirs metadata.
+            QUrl url;
+            stream >> url;
+            return directorySize(url);
+        }
+        case 10: { // Find: QUrl root, QString namePattern, int type, qlonglong minSize, qlonglong modifiedAfter, qlonglong modifiedBefore
+            // Replies through data() with a QDataStream of KIO::UDSEntry per batch of matches, named relative to root.
+            QUrl url;
+            QString namePattern;
+            int type = 0;
+            qlonglong minSize = 0;
+            qlonglong modifiedAfter = 0;
+            qlonglong modifiedBefore = 0;
+            stream >> url >> namePattern >> type >> minSize >> modifiedAfter >> modifiedBefore;
+            return find(url, namePattern, type, minSize, modifiedAfter, modifiedBefore);
+        }
+        case 11: { // Grep: QUrl root, QString fileGlob, QString pattern, int flags (1 regular expression, 2 case insensitive), int maxResults
+            // Replies through data() with a QDataStream of QUrl, qulonglong line number, QString line triples per batch.
+            QUrl url;
+            QString fileGlob;
+            QString pattern;
+            int flags = 0;
+            int maxResults = 0;
+            stream >> url >> fileGlob >> pattern >> flags >> maxResults;
+            return grep(url, fileGlob, pattern, flags, maxResults);
+        }
+        case 12: { // Checksum: QUrl url, QString algorithm (e.g. "sha256", "sha3-256", "blake2b-256"). Replies with checksum metadata, hex encoded.
+            QUrl url;
+            QString algorithm;
+            stream >> url >> algorithm;
+            return checksum(url, algorithm);
+        }
+        case 13: { // Tree copy: QUrl src, QUrl dest, int flags. A local directory is copied as a whole, unlike with KIO::copy.
+            QUrl src;
+            QUrl dest;
+            int flags = 0;
+            stream >> src >> dest >> flags;
+            return copyCommand(src, dest, -1, JobFlags(flags));
+        }
         default:
             break;
         }
@@ -666,7 +1459,87 @@ private Q_SLOTS:
     void entries(const KIO::UDSEntryList &list)
     {
         qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO;
-        listEntries(list);
+        if (m_collectedEntries) {
+            m_collectedEntries->append(list);
+            // Too big to keep around.
+            if (m_collectedEntries->size() > maximumCachedListingSize) {
+                m_collectedEntries.reset();
+            }
+        }
+        if (!m_statDirectory.isEmpty()) {
+            for (const auto &entry : list) {
+                const auto name = entry.stringValue(KIO::UDSEntry::UDS_NAME);
+                if (name != QLatin1String(".") && name != QLatin1String("..") && !entry.contains(UDS_ADMIN_INCOMPLETE)
+                    && m_statEntries.size() < maximumCachedListingSize) {
+                    m_statEntries.insert(name, entry);
+                }
+            }
+        }
+        const auto isIncomplete = [](const KIO::UDSEntry &entry) {
+            return entry.contains(UDS_ADMIN_INCOMPLETE);
+        };
+        if (std::none_of(list.cbegin(), list.cend(), isIncomplete)) {
+            listEntries(list);
+            return;
+        }
+        // Tell the user why there is so little to see about these.
+        auto annotated = list;
+        for (auto &entry : annotated) {
+            if (isIncomplete(entry)) {
+                entry.replace(KIO::UDSEntry::UDS_COMMENT, i18nc("@info:tooltip", "Not responding, details are unavailable"));
+            }
+        }
+        listEntries(annotated);
+    }
+
+    void statEntries(const QList<int> &indexes, const KIO::UDSEntryList &entries)
+    {
+        QByteArray buffer;
+        QDataStream stream(&buffer, QIODevice::WriteOnly);
+        for (qsizetype i = 0; i < indexes.size() && i < entries.size(); ++i) {
+            stream << m_batchUrls.value(indexes.at(i)) << entries.at(i);
+        }
+        data(buffer);
+    }
+
+    void foundEntries(const KIO::UDSEntryList &list)
+    {
+        QByteArray buffer;
+        QDataStream stream(&buffer, QIODevice::WriteOnly);
+        for (const auto &entry : list) {
+            stream << entry;
+        }
+        data(buffer);
+    }
+
+    void mimeTypes(const QStringList &names, const QStringList &mimeTypes)
+    {
+        qCDebug(KIOADMIN_LOG) << Q_FUNC_INFO << names << mimeTypes;
+        auto directory = m_listingUrl.path();
+        if (!directory.endsWith(QLatin1Char('/'))) {
+            directory += QLatin1Char('/');
+        }
+        for (qsizetype i = 0; i < names.size(); ++i) {
+            auto url = m_listingUrl;
+            url.setPath(directory + names.at(i));
+            m_refinedUrls << url;
+            if (m_collectedEntries) {
+                m_sniffedMimeTypes.insert(names.at(i), mimeTypes.value(i));
+            }
+            if (auto it = m_statEntries.find(names.at(i)); it != m_statEntries.end()) {
+                it->replace(KIO::UDSEntry::UDS_MIME_TYPE, mimeTypes.value(i));
+            }
+        }
+    }
+
+    // Per-item failures of tree operations arrive in batches, the overall result carries the first one.
+    void failures(const QStringList &paths, const QList<int> &errors)
+    {
+        QStringList messages;
+        for (qsizetype i = 0; i < paths.size() && i < errors.size(); ++i) {
+            messages << KIO::buildErrorString(errors.at(i), paths.at(i));
+        }
+        warning(messages.join(QLatin1Char('\n')));
     }
 
     void result(int error, const QString &errorString)
@@ -685,6 +1558,21 @@ private:
     std::unique_ptr<OrgKdeKioAdminFileInterface> m_file;
     QEventLoop loop;
     std::optional<quint64> m_pendingWrite = std::nullopt;
+    QUrl m_listingUrl;
+    QList<QUrl> m_batchUrls;
+    QList<QUrl> m_refinedUrls;
+    // Most recent first.
+    QList<CachedListing> m_listings;
+    // Entries of the running listing, while it may still be worth caching.
+    std::optional<KIO::UDSEntryList> m_collectedEntries;
+    QHash<QString, QString> m_sniffedMimeTypes;
+    // Entries of the latest listing by name, for cachedStat().
+    QString m_statDirectory;
+    int m_statDetails = 0;
+    QHash<QString, KIO::UDSEntry> m_statEntries;
+    std::chrono::steady_clock::time_point m_statEntriesAt;
+    // Stats that recently failed with ERR_DOES_NOT_EXIST, by URL.
+    QHash<QString, Missing> m_missing;
 
     inline static std::atomic<std::optional<ReadAuthorizationRequest>> s_previousReadAuthorisationRequest{};
 };